@@ -0,0 +1,642 @@
+// Pitch accuracy harness: every detector is fed generated notes across the whole
+// range, plus optional labelled recordings, and scored against the known pitch.
+// Results go to stdout as CSV, one row per corpus, detector, precision, window and
+// signal. Each row has the cents error, octave and note error rates, how often and
+// how fast the estimate locks, and the CPU time per frame, so every configuration is
+// one point on the accuracy/latency/CPU curve. With --baseline, any row worse than
+// the same row of an earlier run fails the run with exit status 2, and a baseline it
+// cannot be compared with (other columns, or rows this run lacks) with status 1.
+//
+//   g++ -std=c++23 -O2 -o accuracy accuracy.cpp -lfftw3f -lfftw3 -pthread
+//   ./accuracy > before.csv
+//   ./accuracy --baseline before.csv > after.csv
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "adaptive_window.hpp"
+#include "decimator.hpp"
+#include "fft_wisdom.hpp"
+#include "note_gate.hpp"
+#include "note_mapping.hpp"
+#include "pcm_input.hpp"
+#include "pitch_detectors.hpp"
+#include "pitch_tracker.hpp"
+#include "simd_kernels.hpp"
+#include "sliding_window.hpp"
+#include "telemetry.hpp"
+#include "tunings.hpp"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr double SAMPLE_RATE = 44100.0;
+constexpr size_t HOP_SIZE = 512;
+constexpr uint32_t SEED = 0x5EED;
+
+constexpr double GROSS_CENTS = 50.0;    // further off than this reads as another note
+constexpr double LOCK_CENTS = 10.0;     // locked once LOCK_FRAMES estimates in a row are this close
+constexpr size_t LOCK_FRAMES = 3;
+constexpr double MIN_AMPLITUDE = 0.001; // the live gate's floor, for recordings
+
+constexpr std::array DETUNE_CENTS = {-50.0, -25.0, 0.0, 25.0, 50.0};
+
+// Detectors under test, as in the benchmark, plus the decimating front end and the
+// adaptive window, whose window column is its largest size
+struct DetectorCase {
+    std::string_view stage;
+    DetectorKind kind;
+    SpectralPeakOptions peak;
+    size_t decimation = 1;
+    double adaptive_cents = 0.0;
+};
+
+const std::array detector_cases = {
+    DetectorCase{"fft", DetectorKind::fft, {}},
+    DetectorCase{"fft-hps", DetectorKind::fft, {.picking = PeakPicking::hps}},
+    DetectorCase{"fft-pad4", DetectorKind::fft, {.zero_padding = 4}},
+    DetectorCase{"yin", DetectorKind::yin, {}},
+    DetectorCase{"mpm", DetectorKind::mpm, {}},
+    DetectorCase{"fft-dec4", DetectorKind::fft, {.zero_padding = 4}, 4},
+    DetectorCase{"mpm-dec4", DetectorKind::mpm, {}, 4},
+    DetectorCase{"fft-adaptive", DetectorKind::fft, {}, 1, 250.0},
+};
+
+enum class SignalKind { sine, pluck, noisy_pluck };
+
+// sine:  pure tone
+// pluck: 8 harmonics falling as 1/k, each decaying faster than the one below it
+// noisy_pluck: the pluck in white noise at snr_db, relative to the pluck's RMS
+struct SignalCase {
+    std::string_view name;
+    SignalKind kind;
+    double snr_db = 0.0;
+};
+
+constexpr std::array signal_cases = {
+    SignalCase{"sine", SignalKind::sine},
+    SignalCase{"pluck", SignalKind::pluck},
+    SignalCase{"pluck-snr20", SignalKind::noisy_pluck, 20.0},
+    SignalCase{"pluck-snr10", SignalKind::noisy_pluck, 10.0},
+    SignalCase{"pluck-snr0", SignalKind::noisy_pluck, 0.0},
+};
+
+std::vector<float> make_signal(const SignalCase& signal, double f0, size_t length, uint32_t seed) {
+    std::vector<double> value(length, 0.0);
+    for (size_t i = 0; i < length; ++i) {
+        const double t = i / SAMPLE_RATE;
+        if (signal.kind == SignalKind::sine) {
+            value[i] = 0.5 * std::sin(2.0 * std::numbers::pi * f0 * t);
+            continue;
+        }
+        for (int k = 1; k <= 8 && f0 * k < SAMPLE_RATE / 2; ++k) {
+            value[i] += 0.5 / k * std::exp(-0.5 * k * t) * std::sin(2.0 * std::numbers::pi * f0 * k * t);
+        }
+    }
+
+    if (signal.kind == SignalKind::noisy_pluck) {
+        double power = 0.0;
+        for (double v : value) {
+            power += v * v;
+        }
+        const double noise_rms = std::sqrt(power / length) * std::pow(10.0, -signal.snr_db / 20.0);
+        std::mt19937 rng(seed);
+        std::normal_distribution<double> noise(0.0, noise_rms);
+        for (double& v : value) {
+            v += noise(rng);
+        }
+    }
+    return std::vector<float>(value.begin(), value.end());
+}
+
+std::optional<int> parse_note(std::string_view name) {
+    try {
+        return tunings::detail::midi_of(name);
+    } catch (const char*) {
+        return std::nullopt;
+    }
+}
+
+// Scores of one row, accumulated over its cases
+struct Score {
+    size_t cases = 0;
+    size_t frames = 0;          // windows analyzed
+    size_t misses = 0;          // windows the detector found no pitch in
+    size_t gross = 0;           // estimates more than GROSS_CENTS off
+    size_t octave = 0;          // gross estimates a whole number of octaves off
+    size_t note_checked = 0;
+    size_t note_errors = 0;     // the note mapper named another note than the true pitch's
+    size_t locked = 0;
+    std::vector<double> cents;  // |error| of every estimate
+    std::vector<double> lock_ms;
+    uint64_t ns = 0;            // front end and detector, excluding the scoring
+};
+
+double rate(size_t count, size_t total) {
+    return total ? static_cast<double>(count) / total : 0.0;
+}
+
+// NaN for an empty set; printed as an empty field
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    const auto nth = values.begin() + static_cast<ptrdiff_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+// The reported metrics, in column order. Machine-dependent ones are never gated.
+enum class Tolerance { rate, cents, ms, none };
+
+struct Metric {
+    std::string_view name;
+    Tolerance tolerance;
+    bool higher_is_better = false;
+    int digits = 4;
+};
+
+constexpr std::array metrics = {
+    Metric{"miss_rate", Tolerance::rate},
+    Metric{"median_cents", Tolerance::cents},
+    Metric{"p95_cents", Tolerance::cents},
+    Metric{"gross_rate", Tolerance::rate},
+    Metric{"octave_rate", Tolerance::rate},
+    Metric{"note_error_rate", Tolerance::rate},
+    Metric{"lock_rate", Tolerance::rate, true},
+    Metric{"median_lock_ms", Tolerance::ms, false, 1},
+    Metric{"ns_per_frame", Tolerance::none, false, 0},
+};
+
+using MetricValues = std::array<double, metrics.size()>;
+
+MetricValues summarize(const Score& score) {
+    const size_t estimates = score.cents.size();
+    return {
+        rate(score.misses, score.frames),
+        percentile(score.cents, 0.5),
+        percentile(score.cents, 0.95),
+        rate(score.gross, estimates),
+        rate(score.octave, estimates),
+        rate(score.note_errors, score.note_checked),
+        rate(score.locked, score.cases),
+        percentile(score.lock_ms, 0.5),
+        score.frames ? static_cast<double>(score.ns) / score.frames : 0.0,
+    };
+}
+
+struct Options {
+    std::vector<size_t> sizes = {2048, 4096};
+    int low_note = 12;          // C0
+    int high_note = 104;        // G#7
+    double seconds = 0.75;      // per generated note
+    std::string filter;         // only run detectors whose name contains this text
+    std::vector<std::string> clips;
+    std::string baseline;
+    double tolerance_cents = 0.5;
+    double tolerance_rate = 0.01;
+    double tolerance_ms = 12.0; // about one hop
+};
+
+// A recording named after the note it holds: E2.wav, A2_pluck.wav, "G3 take 2.wav".
+// Recordings are expected to be in tune at A4 = 440 Hz.
+struct Clip {
+    std::string name;
+    double truth_hz = 0.0;
+    double sample_rate = 0.0;
+    std::vector<std::vector<float>> channels;
+};
+
+Result<Clip> load_clip(const std::string& path) {
+    const std::string stem = std::filesystem::path(path).stem().string();
+    const std::string_view label = std::string_view(stem).substr(0, stem.find_first_of("_- ."));
+    const auto midi = parse_note(label);
+    if (!midi) {
+        return std::unexpected(TunerError(std::format("{}: the file name does not start with a note name", path)));
+    }
+    auto file = MappedFile::open(path);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    auto wav = parse_wav(file->bytes());
+    if (!wav) {
+        return std::unexpected(TunerError(std::format("{}: {}", path, wav.error().message)));
+    }
+
+    Clip clip{std::filesystem::path(path).filename().string(), tunings::equal_hz(*midi), wav->format.sample_rate, {}};
+    for (size_t c = 0; c < wav->format.channels; ++c) {
+        auto& samples = clip.channels.emplace_back(wav->frames());
+        decode_channel(wav->format, wav->data.data(), wav->frames(), c, samples);
+    }
+    return clip;
+}
+
+// Rows of the baseline compared with this run, and how many of them got worse
+struct Comparison {
+    size_t compared = 0;
+    size_t regressions = 0;
+};
+
+class Report {
+    const Options& options;
+    std::map<std::string, MetricValues> results;    // by row key, for the baseline
+
+    static std::string header() {
+        std::string line = "corpus,detector,precision,window,signal,cases,frames";
+        for (const auto& metric : metrics) {
+            line += std::format(",{}", metric.name);
+        }
+        return line;
+    }
+
+public:
+    explicit Report(const Options& opts) : options(opts) {
+        std::cout << header() << '\n';
+    }
+
+    bool wants(std::string_view stage) const {
+        return options.filter.empty() || stage.find(options.filter) != std::string_view::npos;
+    }
+
+    void add(std::string_view corpus, std::string_view stage, std::string_view precision, size_t window,
+             std::string_view signal, const Score& score) {
+        const auto key = std::format("{},{},{},{},{}", corpus, stage, precision, window, signal);
+        const MetricValues values = summarize(score);
+        std::cout << std::format("{},{},{}", key, score.cases, score.frames);
+        for (size_t m = 0; m < metrics.size(); ++m) {
+            std::cout << ',';
+            if (!std::isnan(values[m])) {
+                std::cout << std::format("{:.{}f}", values[m], metrics[m].digits);
+            }
+        }
+        std::cout << '\n' << std::flush;
+        results[key] = values;
+    }
+
+    // Rows of the baseline that got worse by more than the tolerances. Rows new in this
+    // run are not compared, so a new detector does not fail; every baseline row of a
+    // detector this run measured must have a counterpart, so a changed range, sizes or
+    // column set fails rather than comparing nothing.
+    Result<Comparison> compare_with_baseline() const {
+        std::ifstream in(options.baseline);
+        if (!in) {
+            return std::unexpected(TunerError(std::format("Cannot read baseline {}", options.baseline)));
+        }
+        // Also read with CRLF line endings
+        auto next_line = [&in](std::string& line) {
+            if (!std::getline(in, line)) {
+                return false;
+            }
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            return true;
+        };
+        std::string line;
+        if (!next_line(line) || line != header()) {
+            return std::unexpected(TunerError(std::format("{} does not have the columns of this run", options.baseline)));
+        }
+        Comparison comparison;
+        size_t unmatched = 0;
+        std::string first_unmatched;
+        while (next_line(line)) {
+            std::vector<std::string_view> fields;
+            for (auto part : line | std::views::split(',')) {
+                fields.emplace_back(part.begin(), part.end());
+            }
+            if (fields.size() != 7 + metrics.size()) {
+                return std::unexpected(TunerError(std::format("{}: malformed row: {}", options.baseline, line)));
+            }
+            if (!wants(fields[1])) {
+                continue;
+            }
+            const auto key = std::format("{},{},{},{},{}", fields[0], fields[1], fields[2], fields[3], fields[4]);
+            const auto current = results.find(key);
+            if (current == results.end()) {
+                if (unmatched++ == 0) {
+                    first_unmatched = key;
+                }
+                continue;
+            }
+            ++comparison.compared;
+            for (size_t m = 0; m < metrics.size(); ++m) {
+                const std::string_view field = fields[7 + m];
+                double before = 0.0;
+                if (metrics[m].tolerance == Tolerance::none || field.empty()
+                    || std::from_chars(field.data(), field.data() + field.size(), before).ec != std::errc{}) {
+                    continue;
+                }
+                const double after = current->second[m];
+                const double tolerance = metrics[m].tolerance == Tolerance::rate ? options.tolerance_rate
+                                       : metrics[m].tolerance == Tolerance::cents ? options.tolerance_cents
+                                       : options.tolerance_ms;
+                const bool worse = std::isnan(after)
+                    || (metrics[m].higher_is_better ? after < before - tolerance : after > before + tolerance);
+                if (worse) {
+                    std::cerr << std::format("regression: {} {} {:.4f} -> {:.4f}\n", key, metrics[m].name, before, after);
+                    ++comparison.regressions;
+                }
+            }
+        }
+        if (unmatched) {
+            return std::unexpected(TunerError(std::format("{} rows of {} have no counterpart in this run, starting with {}",
+                                                          unmatched, options.baseline, first_unmatched)));
+        }
+        if (comparison.compared == 0) {
+            return std::unexpected(TunerError(std::format("{} has no rows for this run", options.baseline)));
+        }
+        return comparison;
+    }
+};
+
+// The case's detector for one window size at its analysis rate
+template<typename Real>
+std::unique_ptr<PitchDetector<Real>> make_case_detector(const DetectorCase& detector_case, size_t window, double rate) {
+    auto make = [&](size_t size) {
+        return make_pitch_detector<Real>(detector_case.kind, size, rate, WindowType::hann, detector_case.peak);
+    };
+    if (detector_case.adaptive_cents > 0.0) {
+        return std::make_unique<AdaptiveWindow<Real>>(window, HOP_SIZE / detector_case.decimation, rate,
+                                                      detector_case.adaptive_cents, make);
+    }
+    return make(window);
+}
+
+// Feeds one signal hop by hop through the case's front end and detector, as the live
+// pipeline does, and scores every window. Lock time runs from the start of the
+// first window analyzed; with a gate, recordings skip the silence before the note.
+// An adaptive window is driven by a pitch track, as live, and starts each signal anew.
+template<typename Real>
+void score_signal(const DetectorCase& detector_case, PitchDetector<Real>& detector, std::span<const float> signal,
+                  double sample_rate, double truth_hz, bool check_note, bool gated, const NoteMapper& mapper,
+                  Score& score) {
+    const size_t factor = detector_case.decimation;
+    const size_t window = detector.size();
+    const size_t hop = HOP_SIZE / factor;
+    Decimator decimator(factor, sample_rate / factor);
+    SlidingWindow<float> frames(window, hop);
+    NoteGate gate(hop, sample_rate / factor, MIN_AMPLITUDE);
+    std::vector<float> decimated(hop + 1);
+    std::vector<Real> converted(window);
+    const NoteMatch expected = mapper.nearest(truth_hz);
+    auto* adaptive = dynamic_cast<AdaptiveWindow<Real>*>(&detector);
+    PitchTracker track;
+    if (adaptive) {
+        adaptive->reset();
+    }
+
+    size_t consumed = 0;
+    std::optional<size_t> first_window;
+    size_t streak = 0;
+    bool locked = false;
+
+    auto analyze = [&](std::span<const float> frame) {
+        if (gated) {
+            const bool open = gate.update(frame);
+            if (adaptive && gate.onset()) {
+                track.reset();
+                adaptive->reset();
+            }
+            if (!open) {
+                return;
+            }
+        }
+        if (!first_window) {
+            first_window = consumed - std::min(consumed, window * factor);
+        }
+        ++score.frames;
+        const uint64_t begin = telemetry::now_ns();
+        simd::convert(frame, std::span<Real>(converted));
+        const auto freq = detector.analyze(converted);
+        if (adaptive && freq && *freq > 0.0) {
+            adaptive->adapt(track.update(*freq).frequency, track.window_hint());
+        }
+        score.ns += telemetry::now_ns() - begin;
+        if (!freq || !(*freq > 0.0)) {
+            ++score.misses;
+            streak = 0;
+            return;
+        }
+
+        const double error = 1200.0 * std::log2(*freq / truth_hz);
+        score.cents.push_back(std::abs(error));
+        if (std::abs(error) > GROSS_CENTS) {
+            ++score.gross;
+            const double octaves = std::round(error / 1200.0);
+            if (octaves != 0.0 && std::abs(error - 1200.0 * octaves) <= GROSS_CENTS) {
+                ++score.octave;
+            }
+        }
+        if (check_note) {
+            const NoteMatch note = mapper.nearest(*freq);
+            ++score.note_checked;
+            if (note.note_index != expected.note_index || note.octave != expected.octave) {
+                ++score.note_errors;
+            }
+        }
+        streak = std::abs(error) <= LOCK_CENTS ? streak + 1 : 0;
+        if (!locked && streak == LOCK_FRAMES) {
+            locked = true;
+            score.lock_ms.push_back((consumed - *first_window) * 1000.0 / sample_rate);
+        }
+    };
+
+    for (size_t start = 0; start + HOP_SIZE <= signal.size(); start += HOP_SIZE) {
+        auto input = signal.subspan(start, HOP_SIZE);
+        if (factor > 1) {
+            const uint64_t begin = telemetry::now_ns();
+            input = std::span<const float>(decimated).first(decimator.process(input, decimated));
+            score.ns += telemetry::now_ns() - begin;
+        }
+        consumed = start + HOP_SIZE;
+        frames.push(input, analyze);
+    }
+    ++score.cases;
+    score.locked += locked ? 1 : 0;
+}
+
+template<typename Real>
+constexpr std::string_view precision_name() {
+    return std::is_same_v<Real, float> ? "float" : "double";
+}
+
+template<typename Real>
+void run_precision(Report& report, const Options& options, std::span<const Clip> clips) {
+    constexpr auto precision = precision_name<Real>();
+    const NoteMapper mapper;
+    const size_t length = static_cast<size_t>(options.seconds * SAMPLE_RATE);
+
+    // The generated corpus is the same for every detector, so it is made once
+    std::vector<std::vector<std::vector<float>>> corpus(signal_cases.size());
+    std::vector<double> truth;
+    for (int midi = options.low_note; midi <= options.high_note; ++midi) {
+        for (double detune : DETUNE_CENTS) {
+            truth.push_back(tunings::equal_temperament[midi] * std::exp2(detune / 1200.0));
+        }
+    }
+    for (size_t s = 0; s < signal_cases.size(); ++s) {
+        for (size_t n = 0; n < truth.size(); ++n) {
+            corpus[s].push_back(make_signal(signal_cases[s], truth[n], length, SEED + static_cast<uint32_t>(n)));
+        }
+    }
+
+    for (const auto& detector_case : detector_cases) {
+        if (!report.wants(detector_case.stage)) {
+            continue;
+        }
+        for (size_t size : options.sizes) {
+            const size_t window = size / detector_case.decimation;
+            auto detector = make_case_detector<Real>(detector_case, window, SAMPLE_RATE / detector_case.decimation);
+            for (size_t s = 0; s < signal_cases.size(); ++s) {
+                Score score;
+                for (size_t n = 0; n < truth.size(); ++n) {
+                    // A note detuned by exactly half a semitone has no single right name
+                    const bool check_note = std::abs(DETUNE_CENTS[n % DETUNE_CENTS.size()]) < GROSS_CENTS;
+                    score_signal<Real>(detector_case, *detector, corpus[s][n], SAMPLE_RATE, truth[n], check_note,
+                                       false, mapper, score);
+                }
+                report.add("synthetic", detector_case.stage, precision, size, signal_cases[s].name, score);
+            }
+
+            for (const auto& clip : clips) {
+                auto clip_detector = make_case_detector<Real>(detector_case, window,
+                                                              clip.sample_rate / detector_case.decimation);
+                Score score;
+                for (const auto& channel : clip.channels) {
+                    score_signal<Real>(detector_case, *clip_detector, channel, clip.sample_rate, clip.truth_hz, true,
+                                       true, mapper, score);
+                }
+                report.add("recorded", detector_case.stage, precision, size, clip.name, score);
+            }
+        }
+    }
+}
+
+Result<Options> parse_options(std::span<char*> args) {
+    Options options;
+
+    auto parse_number = [](std::string_view arg, std::string_view value, auto& target) -> Result<void> {
+        if (auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), target);
+            ec != std::errc{} || end != value.data() + value.size() || std::signbit(static_cast<double>(target))) {
+            return std::unexpected(TunerError(std::format("Invalid value for {}: {}", arg, value)));
+        }
+        return {};
+    };
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        std::string_view arg = args[i];
+        if (arg != "--sizes"sv && arg != "--range"sv && arg != "--seconds"sv && arg != "--filter"sv
+            && arg != "--clip"sv && arg != "--baseline"sv && arg != "--tolerance-cents"sv
+            && arg != "--tolerance-rate"sv && arg != "--tolerance-ms"sv) {
+            return std::unexpected(TunerError(std::format("Unknown option: {}", arg)));
+        }
+        if (i + 1 == args.size()) {
+            return std::unexpected(TunerError(std::format("Missing value for {}", arg)));
+        }
+        std::string_view value = args[++i];
+
+        Result<void> parsed;
+        if (arg == "--filter"sv) {
+            options.filter = value;
+        } else if (arg == "--clip"sv) {
+            options.clips.emplace_back(value);
+        } else if (arg == "--baseline"sv) {
+            options.baseline = value;
+        } else if (arg == "--range"sv) {
+            // Lowest and highest note, e.g. E1-E6
+            const size_t dash = value.find('-');
+            const auto low = parse_note(value.substr(0, dash));
+            const auto high = dash == std::string_view::npos ? std::nullopt : parse_note(value.substr(dash + 1));
+            if (!low || !high || *low > *high || *high >= static_cast<int>(tunings::equal_temperament.size())) {
+                return std::unexpected(TunerError(std::format("Invalid note range: {}", value)));
+            }
+            options.low_note = *low;
+            options.high_note = *high;
+        } else if (arg == "--sizes"sv) {
+            options.sizes.clear();
+            for (auto part : value | std::views::split(',')) {
+                size_t size = 0;
+                if (!(parsed = parse_number(arg, std::string_view(part.begin(), part.end()), size))) {
+                    break;
+                }
+                // The decimating cases analyze a quarter of the window
+                if (size < 256 || size % 4 != 0) {
+                    return std::unexpected(TunerError(std::format("Window sizes must be multiples of 4 from 256, got {}", size)));
+                }
+                options.sizes.push_back(size);
+            }
+        } else {
+            parsed = parse_number(arg, value, arg == "--seconds"sv ? options.seconds
+                                            : arg == "--tolerance-cents"sv ? options.tolerance_cents
+                                            : arg == "--tolerance-rate"sv ? options.tolerance_rate
+                                            : options.tolerance_ms);
+        }
+        if (!parsed) {
+            return std::unexpected(parsed.error());
+        }
+    }
+    if (options.seconds * SAMPLE_RATE < static_cast<double>(std::ranges::max(options.sizes) + HOP_SIZE * LOCK_FRAMES)) {
+        return std::unexpected(TunerError("--seconds is too short for the largest window to lock"));
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto options = parse_options(std::span(argv + 1, argc - 1));
+    if (!options) {
+        std::cerr << options.error().message << std::endl;
+        return 1;
+    }
+
+    std::vector<Clip> clips;
+    for (const auto& path : options->clips) {
+        auto clip = load_clip(path);
+        if (!clip) {
+            std::cerr << clip.error().message << std::endl;
+            return 1;
+        }
+        clips.push_back(std::move(*clip));
+    }
+
+    fft_wisdom::Session<float> float_wisdom;
+    fft_wisdom::Session<double> double_wisdom;
+
+    Report report(*options);
+    run_precision<float>(report, *options, clips);
+    run_precision<double>(report, *options, clips);
+
+    if (!options->baseline.empty()) {
+        auto comparison = report.compare_with_baseline();
+        if (!comparison) {
+            std::cerr << comparison.error().message << std::endl;
+            return 1;
+        }
+        std::cerr << comparison->compared << " rows compared with " << options->baseline << std::endl;
+        if (comparison->regressions) {
+            std::cerr << comparison->regressions << " regressions against " << options->baseline << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "pitch_detector.hpp"
+#include "pitch_tracker.hpp"
+
+// Window length chosen per register. A window of N samples resolves rate / N Hz on
+// every note, which is a wide interval in cents on the low E and a narrow one on the
+// high E, and the cents accuracy of every detector follows it. The bank holds one
+// detector per size, halving from the configured window, all built (and their FFT
+// lengths planned) up front. Once the note is known, the smallest window whose
+// resolution at the note is within the target analyzes it, so the treble strings get
+// the shortest latency and the bass strings the length they need. The pitch tracker's
+// window hint then moves between that size and the next: a note held still gets the
+// longer window's precision, one that starts moving gets the short window back.
+// Until the note is known, and after each onset, the largest window analyzes.
+template<typename Real = double>
+class AdaptiveWindow : public PitchDetector<Real> {
+public:
+    static constexpr size_t MAX_SIZES = 4;
+
+private:
+    std::pmr::vector<std::unique_ptr<PitchDetector<Real>>> bank;   // ascending sizes
+    double sample_rate;
+    double target_cents;
+    size_t fit;         // smallest size resolving the current note; bank.size() until known
+    size_t active;
+
+    // Width of one frequency bin of an n-sample window, in cents above the note
+    double resolution_cents(size_t n, double frequency) const {
+        return 1200.0 * std::log2(1.0 + sample_rate / static_cast<double>(n) / frequency);
+    }
+
+public:
+    // make(n) builds the detector for an n-sample window. The bank runs from
+    // largest_size down to MAX_SIZES sizes, none shorter than smallest_size.
+    template<typename Make>
+    AdaptiveWindow(size_t largest_size, size_t smallest_size, double rate, double resolution, Make&& make,
+                   std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        bank(memory),
+        sample_rate(rate),
+        target_cents(resolution) {
+        size_t count = 1;
+        while (count < MAX_SIZES && (largest_size >> count) >= std::max<size_t>(smallest_size, 2)) {
+            ++count;
+        }
+        bank.reserve(count);
+        for (size_t i = count; i-- > 0;) {
+            bank.push_back(make(largest_size >> i));
+        }
+        reset();
+    }
+
+    std::string_view name() const override { return "adaptive"; }
+
+    size_t size() const override { return bank.back()->size(); }
+
+    // Samples the next frame is analyzed over
+    size_t active_size() const { return bank[active]->size(); }
+
+    // Forgets the note, e.g. at a new onset
+    void reset() {
+        fit = bank.size();
+        active = bank.size() - 1;
+    }
+
+    // Chooses the window for the next frames from the tracked note; no note forgets it.
+    // A new note starts at its smallest size, a note already tracked follows the hint.
+    void adapt(double frequency, WindowHint hint) {
+        if (!(frequency > 0.0)) {
+            reset();
+            return;
+        }
+        size_t smallest = bank.size() - 1;
+        while (smallest > 0 && resolution_cents(bank[smallest - 1]->size(), frequency) <= target_cents) {
+            --smallest;
+        }
+        if (smallest != fit) {
+            fit = smallest;
+            active = smallest;
+        } else if (hint == WindowHint::lengthen) {
+            active = std::min(fit + 1, bank.size() - 1);
+        } else if (hint == WindowHint::shorten) {
+            active = fit;
+        }
+    }
+
+    // The frame is the largest window; the active detector reads its newest samples
+    Result<double> analyze(std::span<const Real> audio_data) override {
+        if (audio_data.size() != size()) {
+            return std::unexpected(TunerError("Invalid audio buffer size"));
+        }
+        return bank[active]->analyze(audio_data.last(active_size()));
+    }
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Debug check that the audio and analysis threads never allocate once running.
+// Build with -DTUNER_CHECK_ALLOCATIONS: any operator new on a thread inside a
+// NoAllocations scope then aborts with the size requested, so a regression shows up
+// under a debugger at its first occurrence rather than as an occasional xrun. Without
+// the flag the scope is empty and operator new is the standard one.
+//
+// The replacement operators are defined in this header, so it may be included from
+// only one translation unit per program.
+namespace allocation_guard {
+
+#ifdef TUNER_CHECK_ALLOCATIONS
+inline thread_local bool forbidden = false;
+
+[[noreturn]] inline void report(size_t size) {
+    forbidden = false;
+    std::fprintf(stderr, "allocation of %zu bytes on a real-time thread\n", size);
+    std::abort();
+}
+#endif
+
+// Nests; the outermost scope decides when allocations are allowed again
+class NoAllocations {
+#ifdef TUNER_CHECK_ALLOCATIONS
+    bool previous = forbidden;
+
+public:
+    NoAllocations() { forbidden = true; }
+    ~NoAllocations() { forbidden = previous; }
+#else
+public:
+    NoAllocations() {}
+#endif
+
+    NoAllocations(const NoAllocations&) = delete;
+    NoAllocations& operator=(const NoAllocations&) = delete;
+};
+
+} // namespace allocation_guard
+
+#ifdef TUNER_CHECK_ALLOCATIONS
+// The array and nothrow forms call these by default, so they are covered as well
+void* operator new(size_t size) {
+    if (allocation_guard::forbidden) {
+        allocation_guard::report(size);
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    if (allocation_guard::forbidden) {
+        allocation_guard::report(size);
+    }
+    const size_t alignment = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(alignment, (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
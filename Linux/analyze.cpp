@@ -0,0 +1,38 @@
+// Offline front end: the --analyze mode of extend.cpp on its own, without the
+// display or the audio device, so it builds and runs where neither ncurses nor
+// PortAudio is installed. Takes the same options.
+//
+//   g++ -std=c++23 -O2 -o analyze analyze.cpp -lfftw3f -pthread
+//   ./analyze --analyze recordings/ --detector mpm > pitches.csv
+
+#include <exception>
+#include <span>
+#include "fft_wisdom.hpp"
+#include "logger.hpp"
+#include "offline_analyzer.hpp"
+#include "tuner_settings.hpp"
+
+int main(int argc, char* argv[]) {
+    auto settings = TunerSettings::from_args(std::span(argv + 1, argc - 1));
+    if (!settings) {
+        Logger::error("{}", settings.error().message);
+        return 1;
+    }
+    if (settings->offline_inputs.empty()) {
+        Logger::error("Nothing to analyze: pass --analyze <file|directory|->");
+        return 1;
+    }
+    
+    try {
+        fft_wisdom::Session<Sample> wisdom;
+        OfflineAnalyzer analyzer(*settings);
+        if (auto result = analyzer.run(); !result) {
+            Logger::error("Offline analysis error: {}", result.error().message);
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        Logger::error("Unexpected error: {}", e.what());
+        return 1;
+    }
+    return 0;
+}
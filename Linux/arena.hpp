@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+inline constexpr size_t CACHE_LINE = 64;
+
+// Bump allocator over one contiguous mapping, for everything a stream's analysis
+// touches: its queue, frames, window, FFT buffers and detector scratch. Every block
+// starts on a cache line, so no two buffers share one, and the whole working set of a
+// channel sits in a single range instead of being scattered over the heap.
+//
+// The reservation is address space only; pages are committed as they are first
+// written. Once the stream's state is built, seal() returns the unused tail, and
+// bind_local() moves the pages to the NUMA node of the thread that will use them.
+// Memory is only released when the arena is destroyed, and an allocation beyond the
+// reservation throws std::bad_alloc, so sizing mistakes surface at startup.
+class Arena : public std::pmr::memory_resource {
+    std::byte* base = nullptr;
+    size_t mapped = 0;
+    size_t used = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        const size_t align = std::max(alignment, CACHE_LINE);
+        const size_t offset = (used + align - 1) / align * align;
+        if (offset > mapped || bytes > mapped - offset) {
+            throw std::bad_alloc();
+        }
+        used = offset + bytes;
+        return base + offset;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}   // all at once, in the destructor
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+    // Far more than the largest window needs; untouched pages cost nothing
+    static constexpr size_t DEFAULT_RESERVE = size_t{256} << 20;
+
+    explicit Arena(size_t reserve = DEFAULT_RESERVE) {
+        void* block = ::mmap(nullptr, reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                             -1, 0);
+        if (block == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        base = static_cast<std::byte*>(block);
+        mapped = reserve;
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() override {
+        if (base) {
+            ::munmap(base, mapped);
+        }
+    }
+
+    size_t bytes_used() const noexcept { return used; }
+    size_t capacity() const noexcept { return mapped; }
+
+    // Unmaps the reservation past the last allocation. Anything allocated afterwards
+    // must fit in the remainder of the last page.
+    void seal() {
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        const size_t keep = std::max((used + page - 1) / page * page, page);
+        if (keep < mapped) {
+            ::munmap(base + keep, mapped - keep);
+            mapped = keep;
+        }
+    }
+
+    // Migrates the arena's pages to the calling thread's NUMA node. Returns 0 or an
+    // errno value; a single-node machine or a kernel without NUMA has nothing to move.
+    int bind_local() noexcept {
+        if (::syscall(SYS_mbind, base, mapped, MPOL_LOCAL, nullptr, 0, MPOL_MF_MOVE) != 0) {
+            return errno;
+        }
+        return 0;
+    }
+};
+
+// Fixed-size, zero-initialized, cache-line-aligned array from a memory resource, for
+// buffers that never resize, such as FFTW's, whose complex element is a C array that
+// a vector cannot hold. The default resource makes it an aligned heap array, and an
+// empty buffer allocates nothing.
+template<typename T>
+class AlignedBuffer {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+
+    std::pmr::memory_resource* memory;
+    T* items = nullptr;
+    size_t count = 0;
+
+public:
+    explicit AlignedBuffer(size_t size, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : memory(resource),
+          items(size ? static_cast<T*>(resource->allocate(size * sizeof(T), CACHE_LINE)) : nullptr),
+          count(size) {
+        if (items) {
+            std::memset(static_cast<void*>(items), 0, size * sizeof(T));
+        }
+    }
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept
+        : memory(other.memory), items(std::exchange(other.items, nullptr)), count(std::exchange(other.count, 0)) {}
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        std::swap(memory, other.memory);
+        std::swap(items, other.items);
+        std::swap(count, other.count);
+        return *this;
+    }
+
+    ~AlignedBuffer() {
+        if (items) {
+            memory->deallocate(items, count * sizeof(T), CACHE_LINE);
+        }
+    }
+
+    T* get() const noexcept { return items; }
+    size_t size() const noexcept { return count; }
+    T& operator[](size_t i) const noexcept { return items[i]; }
+    std::span<T> span() const noexcept { return std::span<T>(items, count); }
+};
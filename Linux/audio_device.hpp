@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <ostream>
+#include <string_view>
+#include <portaudio.h>
+
+// Input device selection shared by tuner.cpp and extend.cpp.
+// Without an explicit device, the default input of the lowest-latency host API that
+// is running is used: JACK, then ALSA, then whatever PortAudio considers the default.
+// The sample rate is the requested one or the device's own, so the hardware never
+// has to resample; the analysis is then planned for the rate actually opened.
+namespace audio_device {
+
+// Host APIs tried for the default input, lowest latency first
+inline constexpr std::array<PaHostApiTypeId, 2> preferred_host_apis = { paJACK, paALSA };
+
+// Rates tried, in order, when the device's default rate is not accepted
+inline constexpr std::array<double, 3> fallback_rates = { 48000.0, 44100.0, 96000.0 };
+
+struct InputRequest {
+    std::string_view device;    // index or case-insensitive part of the name; empty = default
+    int channels = 1;
+    double sample_rate = 0.0;   // 0 = the device's default rate
+    double latency_ms = 0.0;    // 0 = the device's low-latency default
+};
+
+struct OpenedInput {
+    PaDeviceIndex device = paNoDevice;
+    double sample_rate = 0.0;   // as reported by the stream
+    double latency_ms = 0.0;
+};
+
+inline const char* host_api_name(const PaDeviceInfo& info)
+{
+    const PaHostApiInfo* host = Pa_GetHostApiInfo(info.hostApi);
+    return host && host->name ? host->name : "?";
+}
+
+inline PaDeviceIndex default_input()
+{
+    for (PaHostApiTypeId type : preferred_host_apis) {
+        const PaHostApiIndex index = Pa_HostApiTypeIdToHostApiIndex(type);
+        const PaHostApiInfo* host = index >= 0 ? Pa_GetHostApiInfo(index) : nullptr;
+        // A host API without a running server (JACK) lists no default input
+        if (host && host->defaultInputDevice != paNoDevice) {
+            return host->defaultInputDevice;
+        }
+    }
+    return Pa_GetDefaultInputDevice();
+}
+
+// An input-capable device by index or name; paNoDevice if nothing matches
+inline PaDeviceIndex find_input(std::string_view spec)
+{
+    if (spec.empty()) {
+        return default_input();
+    }
+
+    const PaDeviceIndex count = Pa_GetDeviceCount();
+    auto has_inputs = [](PaDeviceIndex device) {
+        const PaDeviceInfo* info = Pa_GetDeviceInfo(device);
+        return info && info->maxInputChannels > 0;
+    };
+
+    int index = 0;
+    if (auto [end, ec] = std::from_chars(spec.data(), spec.data() + spec.size(), index);
+        ec == std::errc{} && end == spec.data() + spec.size()) {
+        return index >= 0 && index < count && has_inputs(index) ? index : paNoDevice;
+    }
+
+    auto lower = [](char c) { return std::tolower(static_cast<unsigned char>(c)); };
+    for (PaDeviceIndex device = 0; device < count; ++device) {
+        const PaDeviceInfo* info = Pa_GetDeviceInfo(device);
+        if (!has_inputs(device) || !info->name) {
+            continue;
+        }
+        const std::string_view name = info->name;
+        auto match = std::ranges::search(name, spec, {}, lower, lower);
+        if (!match.empty()) {
+            return device;
+        }
+    }
+    return paNoDevice;
+}
+
+// One line per input device: index, name, host API, channels, rate and latency
+inline void list_inputs(std::ostream& out)
+{
+    const PaDeviceIndex count = Pa_GetDeviceCount();
+    const PaDeviceIndex preferred = default_input();
+    for (PaDeviceIndex device = 0; device < count; ++device) {
+        const PaDeviceInfo* info = Pa_GetDeviceInfo(device);
+        if (!info || info->maxInputChannels <= 0) {
+            continue;
+        }
+        out << (device == preferred ? '*' : ' ') << device << ": " << (info->name ? info->name : "?")
+            << " [" << host_api_name(*info) << "] " << info->maxInputChannels << " in, "
+            << info->defaultSampleRate << " Hz, " << info->defaultLowInputLatency * 1000.0 << " ms\n";
+    }
+}
+
+// Opens a float32 input stream on the requested device, at the requested rate or
+// the first supported of the device default and the common rates
+inline PaError open_input(const InputRequest& request, unsigned long frames_per_buffer,
+    PaStreamCallback* callback, void* user_data, PaStream** stream, OpenedInput* opened)
+{
+    const PaDeviceIndex device = find_input(request.device);
+    const PaDeviceInfo* info = device != paNoDevice ? Pa_GetDeviceInfo(device) : nullptr;
+    if (!info) {
+        return paInvalidDevice;
+    }
+
+    PaStreamParameters parameters{};
+    parameters.device = device;
+    parameters.channelCount = request.channels;
+    parameters.sampleFormat = paFloat32;
+    parameters.suggestedLatency = request.latency_ms > 0.0 ? request.latency_ms / 1000.0 : info->defaultLowInputLatency;
+
+    double rate = request.sample_rate;
+    if (!(rate > 0.0)) {
+        rate = info->defaultSampleRate;
+        for (size_t i = 0; i < fallback_rates.size() && Pa_IsFormatSupported(&parameters, nullptr, rate) != paFormatIsSupported; ++i) {
+            rate = fallback_rates[i];
+        }
+    }
+    if (PaError error = Pa_IsFormatSupported(&parameters, nullptr, rate); error != paFormatIsSupported) {
+        return error;
+    }
+
+    if (PaError error = Pa_OpenStream(stream, &parameters, nullptr, rate, frames_per_buffer, paNoFlag,
+            callback, user_data); error != paNoError) {
+        return error;
+    }
+
+    opened->device = device;
+    opened->sample_rate = rate;
+    opened->latency_ms = parameters.suggestedLatency * 1000.0;
+    if (const PaStreamInfo* stream_info = Pa_GetStreamInfo(*stream)) {
+        opened->sample_rate = stream_info->sampleRate;
+        opened->latency_ms = stream_info->inputLatency * 1000.0;
+    }
+    return paNoError;
+}
+
+} // namespace audio_device
@@ -0,0 +1,352 @@
+// Pitch pipeline benchmarks: each analysis stage and the full pipeline, fed with
+// synthetic signals across window sizes, precisions and detectors.
+// Results go to stdout as CSV, one row per case, so runs can be diffed or loaded
+// into perf tracking. Signals are seeded and nothing depends on the audio device.
+//
+//   g++ -std=c++23 -O2 -o benchmark benchmark.cpp -lfftw3f -lfftw3 -pthread
+//   ./benchmark --sizes 2048,4096 --iterations 5000 > baseline.csv
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <new>
+#include <numbers>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "decimator.hpp"
+#include "fft_wisdom.hpp"
+#include "note_mapping.hpp"
+#include "pitch_detectors.hpp"
+#include "simd_kernels.hpp"
+#include "sliding_window.hpp"
+#include "window_functions.hpp"
+
+using namespace std::literals;
+
+// Every heap allocation is counted, so each case can report allocations per frame
+namespace {
+std::atomic<size_t> allocation_count{0};
+}
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const size_t alignment = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// Out of line, so the compiler does not pair the inlined free() with operator new
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr double SAMPLE_RATE = 44100.0;
+constexpr size_t HOP_SIZE = 512;
+constexpr uint32_t SEED = 0x5EED;
+
+enum class SignalKind { tone, pluck, noise };
+
+constexpr std::string_view signal_name(SignalKind kind) {
+    switch (kind) {
+        case SignalKind::pluck: return "pluck";
+        case SignalKind::noise: return "noise";
+        case SignalKind::tone: break;
+    }
+    return "tone";
+}
+
+// tone:  pure A2 sine
+// pluck: A2 with 8 decaying harmonics, roughly a plucked string
+// noise: uniform white noise, loud enough to pass the gate
+std::vector<float> make_signal(SignalKind kind, size_t length) {
+    constexpr double f0 = 110.0;
+    std::vector<float> signal(length);
+    std::mt19937 rng(SEED);
+    std::uniform_real_distribution<float> uniform(-0.5f, 0.5f);
+
+    for (size_t i = 0; i < length; ++i) {
+        const double t = i / SAMPLE_RATE;
+        double value = 0.0;
+        switch (kind) {
+            case SignalKind::tone:
+                value = 0.5 * std::sin(2.0 * std::numbers::pi * f0 * t);
+                break;
+            case SignalKind::pluck:
+                for (int k = 1; k <= 8; ++k) {
+                    value += 0.5 / k * std::exp(-0.5 * k * t) * std::sin(2.0 * std::numbers::pi * f0 * k * t);
+                }
+                break;
+            case SignalKind::noise:
+                value = uniform(rng);
+                break;
+        }
+        signal[i] = static_cast<float>(value);
+    }
+    return signal;
+}
+
+struct Options {
+    std::vector<size_t> sizes = {1024, 2048, 4096, 8192};
+    size_t iterations = 2000;
+    size_t warmup = 200;
+    std::string filter;     // only run cases whose stage contains this text
+};
+
+struct Stats {
+    double mean_ns = 0.0;
+    double p50_ns = 0.0;
+    double p99_ns = 0.0;
+    double p999_ns = 0.0;
+    double allocations_per_frame = 0.0;
+};
+
+// Times body(i) once per iteration; the latency buffer is allocated before the
+// counted region so only the body's own allocations are reported
+template<typename Body>
+Stats measure(const Options& options, Body&& body) {
+    using clock = std::chrono::steady_clock;
+
+    for (size_t i = 0; i < options.warmup; ++i) {
+        body(i);
+    }
+
+    std::vector<double> latencies(options.iterations);
+    const size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < options.iterations; ++i) {
+        const auto start = clock::now();
+        body(i);
+        latencies[i] = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    }
+    const size_t allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+
+    Stats stats;
+    for (double ns : latencies) {
+        stats.mean_ns += ns;
+    }
+    stats.mean_ns /= latencies.size();
+
+    std::ranges::sort(latencies);
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+    stats.p50_ns = percentile(0.50);
+    stats.p99_ns = percentile(0.99);
+    stats.p999_ns = percentile(0.999);
+    stats.allocations_per_frame = static_cast<double>(allocations) / options.iterations;
+    return stats;
+}
+
+// Keeps results observable so the measured work is not optimized away
+volatile double sink = 0.0;
+
+class Report {
+    const Options& options;
+
+public:
+    explicit Report(const Options& opts) : options(opts) {
+        std::cout << "stage,precision,window,signal,isa,iterations,ns_per_frame,p50_ns,p99_ns,p999_ns,allocs_per_frame\n";
+    }
+
+    bool wants(std::string_view stage) const {
+        return options.filter.empty() || stage.find(options.filter) != std::string_view::npos;
+    }
+
+    template<typename Body>
+    void run(std::string_view stage, std::string_view precision, size_t window, std::string_view signal, Body&& body) {
+        if (!wants(stage)) {
+            return;
+        }
+        const Stats stats = measure(options, body);
+        std::cout << std::format("{},{},{},{},{},{},{:.1f},{:.1f},{:.1f},{:.1f},{:.3f}\n",
+            stage, precision, window, signal, simd::active_isa(), options.iterations,
+            stats.mean_ns, stats.p50_ns, stats.p99_ns, stats.p999_ns, stats.allocations_per_frame) << std::flush;
+    }
+};
+
+// Detectors under test; the FFT detector also runs with HPS and with 4x zero padding
+struct DetectorCase {
+    std::string_view stage;
+    DetectorKind kind;
+    SpectralPeakOptions peak;
+};
+
+const std::array detector_cases = {
+    DetectorCase{"fft", DetectorKind::fft, {}},
+    DetectorCase{"fft-hps", DetectorKind::fft, {.picking = PeakPicking::hps}},
+    DetectorCase{"fft-pad4", DetectorKind::fft, {.zero_padding = 4}},
+    DetectorCase{"yin", DetectorKind::yin, {}},
+    DetectorCase{"mpm", DetectorKind::mpm, {}},
+};
+
+template<typename Real>
+constexpr std::string_view precision_name() {
+    return std::is_same_v<Real, float> ? "float" : "double";
+}
+
+template<typename Real>
+void run_precision(Report& report, const Options& options) {
+    constexpr auto precision = precision_name<Real>();
+    const NoteMapper mapper;
+
+    // Note lookup does not depend on the window or the signal; sweep the guitar range
+    report.run("note", precision, 0, "sweep", [&](size_t i) {
+        sink = mapper.nearest(80.0 + (i % 1000) * 1.2).cents;
+    });
+
+    // The decimating front end works on float samples whatever the analysis precision;
+    // each iteration takes enough device samples for one hop at the reduced rate
+    if constexpr (std::is_same_v<Real, float>) {
+        for (size_t factor : {2, 4, 8}) {
+            const size_t input = HOP_SIZE * factor;
+            const auto signal = make_signal(SignalKind::pluck, input * 64);
+            Decimator decimator(factor, SAMPLE_RATE / factor);
+            std::vector<float> out(HOP_SIZE + 1);
+            report.run(std::format("decimate-{}", factor), precision, input, signal_name(SignalKind::pluck), [&](size_t i) {
+                const auto hop = std::span<const float>(signal).subspan((i % 64) * input, input);
+                sink = out[decimator.process(hop, out) - 1];
+            });
+        }
+    }
+
+    for (size_t size : options.sizes) {
+        const size_t length = size + HOP_SIZE * 64;
+
+        for (SignalKind kind : {SignalKind::tone, SignalKind::pluck, SignalKind::noise}) {
+            const auto signal = make_signal(kind, length);
+            const auto name = signal_name(kind);
+
+            // Successive iterations read successive hops, as the live pipeline does
+            auto frame_at = [&](size_t i) {
+                return std::span<const float>(signal).subspan((i * HOP_SIZE) % (length - size), size);
+            };
+
+            std::vector<Real> converted(size);
+            std::vector<Real> windowed(size);
+            const WindowTable<Real> window(WindowType::hann, size);
+
+            report.run("gate", precision, size, name, [&](size_t i) {
+                sink = simd::rms(frame_at(i));
+            });
+
+            report.run("window", precision, size, name, [&](size_t i) {
+                simd::apply_window(frame_at(i), window.coefficients(), std::span<Real>(windowed));
+                sink = windowed[size / 2];
+            });
+
+            for (const auto& detector_case : detector_cases) {
+                auto detector = make_pitch_detector<Real>(detector_case.kind, size, SAMPLE_RATE, WindowType::hann,
+                                                          detector_case.peak);
+                const std::string stage(detector_case.stage);
+
+                report.run(stage, precision, size, name, [&](size_t i) {
+                    simd::convert(frame_at(i), std::span<Real>(converted));
+                    if (auto freq = detector->analyze(converted)) {
+                        sink = *freq;
+                    }
+                });
+
+                // Full pipeline per hop: sliding window, gate, detector and note mapping
+                SlidingWindow<float> frames(size, HOP_SIZE);
+                report.run("pipeline-"s + stage, precision, size, name, [&](size_t i) {
+                    const auto hop = std::span<const float>(signal).subspan((i * HOP_SIZE) % (length - HOP_SIZE), HOP_SIZE);
+                    frames.push(hop, [&](std::span<const float> frame) {
+                        if (simd::rms(frame) <= 0.01) {
+                            return;
+                        }
+                        simd::convert(frame, std::span<Real>(converted));
+                        if (auto freq = detector->analyze(converted)) {
+                            sink = mapper.nearest(*freq).cents;
+                        }
+                    });
+                });
+            }
+        }
+    }
+}
+
+Result<Options> parse_options(std::span<char*> args) {
+    Options options;
+
+    auto parse_size = [](std::string_view arg, std::string_view value) -> Result<size_t> {
+        size_t parsed = 0;
+        if (auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+            ec != std::errc{} || end != value.data() + value.size() || parsed == 0) {
+            return std::unexpected(TunerError(std::format("Invalid value for {}: {}", arg, value)));
+        }
+        return parsed;
+    };
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        std::string_view arg = args[i];
+        if (arg != "--sizes"sv && arg != "--iterations"sv && arg != "--warmup"sv && arg != "--filter"sv) {
+            return std::unexpected(TunerError(std::format("Unknown option: {}", arg)));
+        }
+        if (i + 1 == args.size()) {
+            return std::unexpected(TunerError(std::format("Missing value for {}", arg)));
+        }
+        std::string_view value = args[++i];
+
+        if (arg == "--filter"sv) {
+            options.filter = value;
+        } else if (arg == "--sizes"sv) {
+            options.sizes.clear();
+            for (auto part : value | std::views::split(',')) {
+                auto size = parse_size(arg, std::string_view(part.begin(), part.end()));
+                if (!size) {
+                    return std::unexpected(size.error());
+                }
+                options.sizes.push_back(*size);
+            }
+        } else {
+            auto count = parse_size(arg, value);
+            if (!count) {
+                return std::unexpected(count.error());
+            }
+            (arg == "--iterations"sv ? options.iterations : options.warmup) = *count;
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto options = parse_options(std::span(argv + 1, argc - 1));
+    if (!options) {
+        std::cerr << options.error().message << std::endl;
+        return 1;
+    }
+
+    // Cached wisdom keeps the measured plans identical from run to run
+    fft_wisdom::Session<float> float_wisdom;
+    fft_wisdom::Session<double> double_wisdom;
+
+    Report report(*options);
+    run_precision<float>(report, *options);
+    run_precision<double>(report, *options);
+    return 0;
+}
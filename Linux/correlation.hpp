@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <memory_resource>
+#include <span>
+#include "arena.hpp"
+#include "fft_wisdom.hpp"
+#include "fftw_traits.hpp"
+
+// FFT-accelerated correlation for the time-domain pitch detectors.
+// Frames are zero-padded to twice their length so the circular correlation computed
+// through the spectrum equals the linear one for every lag, at O(N log N) cost
+// instead of the O(N^2) direct sum. All buffers and plans are created up front.
+template<typename Real = double>
+class Correlator {
+    using Api = Fftw<Real>;
+    using Complex = typename Api::complex;
+    using RealBuffer = AlignedBuffer<Real>;
+    using ComplexBuffer = AlignedBuffer<Complex>;
+    
+    size_t frame_size;
+    size_t fft_size;
+    RealBuffer time;
+    ComplexBuffer spectrum;
+    ComplexBuffer reference_spectrum;
+    typename Api::plan forward;
+    typename Api::plan inverse;
+    
+    void transform(std::span<const Real> samples, Complex* out) {
+        std::ranges::copy(samples, time.get());
+        std::fill(time.get() + samples.size(), time.get() + fft_size, Real(0));
+        Api::execute_r2c(forward, time.get(), out);
+    }
+    
+    void inverse_into(std::span<Real> out) {
+        Api::execute(inverse);
+        const Real scale = Real(1) / fft_size;
+        const size_t lags = std::min(out.size(), frame_size);
+        for (size_t i = 0; i < lags; ++i) {
+            out[i] = time[i] * scale;
+        }
+    }
+    
+public:
+    explicit Correlator(size_t size, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        frame_size(size),
+        fft_size(2 * size),
+        time(fft_size, memory),
+        spectrum(fft_size / 2 + 1, memory),
+        reference_spectrum(fft_size / 2 + 1, memory) {
+        
+        forward = fft_wisdom::plan_r2c<Real>(fft_size, time.get(), spectrum.get(), FFTW_MEASURE);
+        inverse = fft_wisdom::plan_c2r<Real>(fft_size, spectrum.get(), time.get(), FFTW_MEASURE);
+    }
+    
+    ~Correlator() {
+        Api::destroy(inverse);
+        Api::destroy(forward);
+    }
+    
+    Correlator(const Correlator&) = delete;
+    Correlator& operator=(const Correlator&) = delete;
+    
+    size_t size() const { return frame_size; }
+    
+    // out[tau] = sum_j x[j] * x[j + tau]
+    void autocorrelate(std::span<const Real> frame, std::span<Real> out) {
+        transform(frame, spectrum.get());
+        for (size_t k = 0; k <= fft_size / 2; ++k) {
+            spectrum[k][0] = spectrum[k][0] * spectrum[k][0] + spectrum[k][1] * spectrum[k][1];
+            spectrum[k][1] = Real(0);
+        }
+        inverse_into(out);
+    }
+    
+    // out[tau] = sum_j reference[j] * frame[j + tau]
+    void cross_correlate(std::span<const Real> reference, std::span<const Real> frame, std::span<Real> out) {
+        transform(reference, reference_spectrum.get());
+        transform(frame, spectrum.get());
+        for (size_t k = 0; k <= fft_size / 2; ++k) {
+            const Real re = spectrum[k][0] * reference_spectrum[k][0] + spectrum[k][1] * reference_spectrum[k][1];
+            const Real im = spectrum[k][1] * reference_spectrum[k][0] - spectrum[k][0] * reference_spectrum[k][1];
+            spectrum[k][0] = re;
+            spectrum[k][1] = im;
+        }
+        inverse_into(out);
+    }
+};
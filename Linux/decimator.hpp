@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <memory_resource>
+#include <numbers>
+#include <span>
+#include <vector>
+#include "simd_kernels.hpp"
+
+// Band-limiting front end of the analysis: a cascade of half-band low-pass filters,
+// each halving the rate, followed by a high-pass at the output rate. A guitar's
+// fundamentals lie between about 70 Hz and 1.4 kHz, so after decimating by 4 or 8 a
+// 512-1024 point window resolves as finely as 4096 points at the device rate, and
+// hiss, whine and pick noise above the band can no longer win the spectral peak.
+// Rumble and DC below the lowest bass string are removed by the high-pass.
+class Decimator {
+    // Blackman-windowed half-band FIR. Every other tap is zero apart from the centre
+    // one (0.5), so in polyphase form an output is one contiguous dot product over
+    // the samples of its own phase plus half of a single sample of the other phase.
+    class HalfBand {
+        std::pmr::vector<float> taps;   // the nonzero off-centre taps, symmetric
+        std::pmr::vector<float> even;   // output-phase samples, stored twice so the newest taps.size() are contiguous
+        std::pmr::vector<float> odd;    // other-phase samples, stored twice; the oldest is the centre tap's
+        size_t even_pos = 0;        // index of the oldest sample
+        size_t odd_pos = 0;
+        bool output_next = false;   // the next input is an output-phase sample
+
+    public:
+        // branch_taps + 1 nonzero taps out of 2 * branch_taps - 1; branch_taps is even
+        HalfBand(size_t branch_taps, std::pmr::memory_resource* memory) :
+            taps(branch_taps, memory),
+            even(2 * branch_taps, memory),
+            odd(branch_taps, memory) {
+            const size_t length = 2 * branch_taps - 1;
+            const double center = 0.5 * static_cast<double>(length - 1);
+            double sum = 0.0;
+            for (size_t j = 0; j < branch_taps; ++j) {
+                const double i = 2.0 * static_cast<double>(j);
+                const double t = i - center;
+                const double sinc = std::sin(0.5 * std::numbers::pi * t) / (std::numbers::pi * t);
+                const double phase = 2.0 * std::numbers::pi * i / static_cast<double>(length - 1);
+                taps[j] = static_cast<float>(sinc * (0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase)));
+                sum += taps[j];
+            }
+            // Off-centre taps sum to 0.5, the centre tap adds the other half: unity at DC
+            for (float& tap : taps) {
+                tap = static_cast<float>(0.5 * tap / sum);
+            }
+        }
+
+        size_t output_count(size_t inputs) const noexcept {
+            return (inputs + (output_next ? 1 : 0)) / 2;
+        }
+
+        // Feeds one sample; true with the output in out on every second call
+        bool push(float sample, float& out) noexcept {
+            if (!output_next) {
+                odd[odd_pos] = sample;
+                odd[odd_pos + odd.size() / 2] = sample;
+                odd_pos = (odd_pos + 1) % (odd.size() / 2);
+                output_next = true;
+                return false;
+            }
+            even[even_pos] = sample;
+            even[even_pos + taps.size()] = sample;
+            even_pos = (even_pos + 1) % taps.size();
+            output_next = false;
+
+            out = simd::dot(std::span<const float>(even).subspan(even_pos, taps.size()), taps)
+                + 0.5f * odd[odd_pos];
+            return true;
+        }
+    };
+
+    // The last stage carries the final transition band and needs the sharp filter;
+    // earlier ones only have to keep their alias band clear of the final passband
+    static constexpr size_t FINAL_BRANCH_TAPS = 32;
+    static constexpr size_t EARLY_BRANCH_TAPS = 12;
+    // Under the B0 of a 5-string bass (30.9 Hz), which loses less than 2 dB; a cutoff
+    // near the low E would let the 2nd harmonic of E1 and lower win the peak
+    static constexpr double HIGHPASS_HZ = 25.0;
+
+    size_t step;
+    std::pmr::vector<HalfBand> stages;
+
+    // Second-order Butterworth high-pass, direct form I
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+
+    float highpass(float sample) noexcept {
+        const double y = b0 * sample + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = sample;
+        y2 = y1;
+        y1 = y;
+        return static_cast<float>(y);
+    }
+
+public:
+    // factor is 1, 2, 4 or 8; output_rate is the rate after decimation. A factor of 1
+    // would only apply the high-pass, and the pipelines bypass the decimator then, so
+    // the high-pass comes with --decimate alone.
+    Decimator(size_t factor, double output_rate, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        step(std::max<size_t>(std::bit_floor(factor), 1)),
+        stages(memory) {
+        stages.reserve(static_cast<size_t>(std::countr_zero(step)));
+        for (size_t f = step; f > 1; f /= 2) {
+            stages.emplace_back(f == 2 ? FINAL_BRANCH_TAPS : EARLY_BRANCH_TAPS, memory);
+        }
+
+        const double k = std::tan(std::numbers::pi * HIGHPASS_HZ / output_rate);
+        const double norm = 1.0 / (1.0 + std::numbers::sqrt2 * k + k * k);
+        b0 = norm;
+        b1 = -2.0 * norm;
+        b2 = norm;
+        a1 = 2.0 * (k * k - 1.0) * norm;
+        a2 = (1.0 - std::numbers::sqrt2 * k + k * k) * norm;
+    }
+
+    size_t factor() const noexcept { return step; }
+
+    // Outputs produced by the next `inputs` samples
+    size_t output_count(size_t inputs) const noexcept {
+        for (const auto& stage : stages) {
+            inputs = stage.output_count(inputs);
+        }
+        return inputs;
+    }
+
+    // Filters `in` and writes one sample per factor inputs to `out`, which must hold
+    // output_count(in.size()); returns the number written. State carries over, so a
+    // stream can be fed in blocks of any size.
+    size_t process(std::span<const float> in, std::span<float> out) noexcept {
+        size_t written = 0;
+        for (float sample : in) {
+            bool ready = true;
+            for (auto& stage : stages) {
+                if (!stage.push(sample, sample)) {
+                    ready = false;
+                    break;
+                }
+            }
+            if (ready) {
+                out[written++] = highpass(sample);
+            }
+        }
+        return written;
+    }
+};
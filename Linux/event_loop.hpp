@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+// The main thread's only wait, shared by tuner.cpp and extend.cpp: one epoll set over
+// stdin, a signalfd for SIGINT and SIGTERM, and an eventfd that analysis threads
+// signal when they publish a result. The thread sleeps until one of them fires or an
+// optional deadline passes, so a result is drawn as soon as it exists and nothing
+// wakes the CPU during silence.
+//
+// Construct it before any other thread starts: the signals are blocked in the
+// constructor, and threads created afterwards inherit the mask, so the signalfd is
+// the only place they are delivered.
+class EventLoop {
+public:
+    struct Events {
+        bool input = false;     // stdin is readable, or at end of file
+        bool result = false;    // notify() was called since the last wait
+        int signal = 0;         // SIGINT or SIGTERM, 0 if neither arrived
+    };
+
+    explicit EventLoop(bool watch_input)
+    {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        signal_fd = signalfd(-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+        event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        valid = epoll_fd >= 0 && signal_fd >= 0 && event_fd >= 0 && watch(signal_fd) && watch(event_fd);
+        // A regular file cannot be polled (and never blocks); it is simply not watched
+        input_watched = valid && watch_input && watch(STDIN_FILENO);
+    }
+
+    ~EventLoop()
+    {
+        for (int fd : {event_fd, signal_fd, epoll_fd}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool is_valid() const { return valid; }
+
+    // From any thread. Results published while the loop has not yet woken cost no
+    // further syscall: only the first one after each wait writes the eventfd.
+    void notify() noexcept
+    {
+        if (!pending.exchange(true, std::memory_order_acq_rel)) {
+            const uint64_t one = 1;
+            [[maybe_unused]] ssize_t written = write(event_fd, &one, sizeof(one));
+        }
+    }
+
+    // Stops watching stdin, e.g. at end of file when it is not a terminal
+    void ignore_input()
+    {
+        if (input_watched) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, STDIN_FILENO, nullptr);
+            input_watched = false;
+        }
+    }
+
+    // Blocks until something happens or timeout_ms passes (-1 = no timeout)
+    Events wait(int timeout_ms = -1)
+    {
+        Events events;
+        epoll_event ready[3];
+        int count = epoll_wait(epoll_fd, ready, 3, timeout_ms);
+        if (count < 0 && errno != EINTR) {
+            events.signal = SIGTERM;    // the loop cannot wait any more; shut down
+            return events;
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = ready[i].data.fd;
+            if (fd == STDIN_FILENO) {
+                events.input = true;
+            } else if (fd == event_fd) {
+                // Drained before pending is cleared: a notify in between sees pending
+                // still set and skips its write, and this exchange then acquires its result
+                uint64_t value;
+                [[maybe_unused]] ssize_t got = read(event_fd, &value, sizeof(value));
+                pending.exchange(false, std::memory_order_acq_rel);
+                events.result = true;
+            } else if (fd == signal_fd) {
+                signalfd_siginfo info;
+                while (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+                    events.signal = static_cast<int>(info.ssi_signo);
+                }
+            }
+        }
+        return events;
+    }
+
+private:
+    int epoll_fd = -1;
+    int signal_fd = -1;
+    int event_fd = -1;
+    bool valid = false;
+    bool input_watched = false;
+    std::atomic<bool> pending{false};
+
+    bool watch(int fd)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+    }
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <vector>
+#include "arena.hpp"
+#include "fft_wisdom.hpp"
+#include "fftw_traits.hpp"
+#include "pitch_detector.hpp"
+#include "simd_kernels.hpp"
+#include "spectral_peak.hpp"
+#include "window_functions.hpp"
+
+// Modern FFT analyzer using RAII and modern memory management.
+// FFTAnalyzer<float> runs on fftwf_* end to end; FFTAnalyzer<double> is kept for
+// measurement-grade use.
+// With zero padding the windowed frame is transformed at 2x or 4x its length, which
+// samples the same spectrum on a finer grid: the interpolated peak of a short window
+// then reaches the accuracy of a longer one without its latency.
+template<typename Real = double>
+class FFTAnalyzer : public PitchDetector<Real> {
+    using Api = Fftw<Real>;
+    using Complex = typename Api::complex;
+    
+    // Lowest fundamental HPS considers; keeps DC and rumble out of the product
+    static constexpr double MIN_FUNDAMENTAL_HZ = 25.0;
+    // A fundamental more than 30 dB below the strongest bin (ln of the power ratio) is not trusted
+    static constexpr double HPS_DYNAMIC_RANGE = 6.9;
+    static constexpr size_t REFINE_PARTIALS = 3;
+    
+    size_t window_size;
+    size_t fft_size;
+    double sample_rate;
+    SpectralPeakOptions options;
+    WindowTable<Real> window;
+    AlignedBuffer<Real> input;
+    AlignedBuffer<Complex> output;
+    std::pmr::vector<double> log_power;     // HPS only
+    typename Api::plan plan;        // owned by the plan cache
+
+    // HPS settles which partial is the fundamental; the frequency itself comes from the
+    // strongest of the first partials divided by its number, which divides the bin error
+    // too. Higher partials are left out, as string inharmonicity pulls them sharp.
+    Result<double> hps_fundamental() {
+        spectral::log_power(output.get(), log_power);
+        
+        const auto begin = static_cast<size_t>(std::ceil(MIN_FUNDAMENTAL_HZ * fft_size / sample_rate));
+        const double strongest = *std::max_element(log_power.begin() + std::min(begin, log_power.size() - 1), log_power.end());
+        const auto found = spectral::harmonic_product_peak(log_power, options.harmonics, begin,
+                                                           strongest - HPS_DYNAMIC_RANGE);
+        if (!found) {
+            return std::unexpected(TunerError("Window too short for the lowest fundamental"));
+        }
+        const size_t fundamental = *found;
+        
+        size_t best_partial = 1;
+        size_t best_bin = spectral::climb_to_peak(log_power, fundamental);
+        for (size_t h = 2; h <= std::min<size_t>(REFINE_PARTIALS, options.harmonics); ++h) {
+            if (h * fundamental >= log_power.size()) {
+                break;
+            }
+            const size_t bin = spectral::climb_to_peak(log_power, h * fundamental);
+            if (log_power[bin] > log_power[best_bin]) {
+                best_partial = h;
+                best_bin = bin;
+            }
+        }
+        return spectral::interpolate_peak(log_power, best_bin) / best_partial * sample_rate / fft_size;
+    }
+    
+public:
+    explicit FFTAnalyzer(size_t size, double rate = 44100.0, WindowType type = WindowType::hann,
+                         const SpectralPeakOptions& peak = {},
+                         std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        window_size(size),
+        fft_size(size * std::max<size_t>(peak.zero_padding, 1)),
+        sample_rate(rate),
+        options(peak),
+        window(type, window_size, memory),
+        input(fft_size, memory),
+        output(fft_size / 2 + 1, memory),
+        log_power(memory),
+        plan(fft_wisdom::PlanCache<Real>::instance().r2c(static_cast<int>(fft_size))) {
+        
+        if (!plan) {
+            throw std::bad_alloc();
+        }
+        // The padding stays zero; only the first window_size samples are rewritten per frame.
+        // The coefficients live in their own read-only table and are never touched.
+        if (options.picking == PeakPicking::hps) {
+            log_power.resize(fft_size / 2);
+        }
+    }
+    
+    std::string_view name() const override { return "fft"; }
+    
+    size_t size() const override { return window_size; }
+    
+    Result<double> analyze(std::span<const Real> audio_data) override {
+        if (audio_data.size() != window_size) {
+            return std::unexpected(TunerError("Invalid audio buffer size"));
+        }
+        
+        // Window the frame into the FFT input in a single pass
+        simd::multiply(audio_data, window.coefficients(), std::span<Real>(input.get(), window_size));
+        
+        Api::execute_r2c(plan, input.get(), output.get());
+        
+        if (options.picking == PeakPicking::hps) {
+            return hps_fundamental();
+        }
+        
+        // The argmax of the squared magnitude is the same bin, so no hypot/sqrt is needed
+        const size_t bins = fft_size / 2;
+        const size_t peak_bin = simd::peak_power(output.get(), 1, bins).index;
+        
+        // Sub-bin refinement on log magnitude (both parts of each bin)
+        const double peak = spectral::interpolate_peak(output.get(), bins, peak_bin);
+        return peak * sample_rate / fft_size;
+    }
+};
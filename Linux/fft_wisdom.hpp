@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include "fftw_traits.hpp"
+
+// FFTW wisdom cache shared by tuner.cpp and extend.cpp.
+// Wisdom is loaded from the user's cache dir on startup so that measured plans
+// cost almost nothing to create after the first run, and saved back on exit.
+// Double and single precision keep separate wisdom files.
+namespace fft_wisdom {
+
+// Window sizes pre-planned by --generate-wisdom
+inline constexpr std::array<int, 7> supported_window_sizes = { 256, 512, 1024, 2048, 4096, 8192, 16384 };
+
+// $XDG_CACHE_HOME/guitar-tuner, falling back to ~/.cache
+inline std::filesystem::path cache_dir()
+{
+    std::filesystem::path base;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        base = xdg;
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        base = std::filesystem::path(home) / ".cache";
+    } else {
+        base = std::filesystem::temp_directory_path();
+    }
+    return base / "guitar-tuner";
+}
+
+template<typename Real = double>
+std::filesystem::path cache_path()
+{
+    return cache_dir() / Fftw<Real>::wisdom_file;
+}
+
+template<typename Real = double>
+bool load()
+{
+    return Fftw<Real>::import_wisdom(cache_path<Real>().c_str());
+}
+
+template<typename Real = double>
+bool save()
+{
+    auto path = cache_path<Real>();
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+    return Fftw<Real>::export_wisdom(path.c_str());
+}
+
+// Creates an r2c plan from wisdom when possible and only falls back to a real
+// MEASURE/PATIENT search when no wisdom exists for this size.
+// Planning may overwrite in/out, so call it before filling the buffers.
+template<typename Real>
+typename Fftw<Real>::plan plan_r2c(int n, Real* in, typename Fftw<Real>::complex* out, unsigned int flags = FFTW_MEASURE)
+{
+    if (auto plan = Fftw<Real>::plan_r2c(n, in, out, flags | FFTW_WISDOM_ONLY)) {
+        return plan;
+    }
+    return Fftw<Real>::plan_r2c(n, in, out, flags);
+}
+
+// Inverse counterpart of plan_r2c, used by the correlation-based pitch detectors
+template<typename Real>
+typename Fftw<Real>::plan plan_c2r(int n, typename Fftw<Real>::complex* in, Real* out, unsigned int flags = FFTW_MEASURE)
+{
+    if (auto plan = Fftw<Real>::plan_c2r(n, in, out, flags | FFTW_WISDOM_ONLY)) {
+        return plan;
+    }
+    return Fftw<Real>::plan_c2r(n, in, out, flags);
+}
+
+// Process-wide r2c plans, one per transform length, shared by every analyzer of that
+// length. The plans are made on scratch buffers and run with the new-array execute
+// (Fftw::execute_r2c), so callers only need FFTW-allocated buffers of their own.
+// Planning is serialized here, but other planner calls must not run concurrently.
+template<typename Real>
+class PlanCache {
+    using Api = Fftw<Real>;
+
+    std::mutex mutex;
+    std::map<int, typename Api::plan> forward;
+
+    PlanCache() = default;
+
+public:
+    ~PlanCache()
+    {
+        for (auto& [n, plan] : forward) {
+            Api::destroy(plan);
+        }
+    }
+
+    static PlanCache& instance()
+    {
+        static PlanCache cache;
+        return cache;
+    }
+
+    // Null if FFTW could not plan this length
+    typename Api::plan r2c(int n, unsigned int flags = FFTW_MEASURE)
+    {
+        std::lock_guard lock(mutex);
+        if (auto it = forward.find(n); it != forward.end()) {
+            return it->second;
+        }
+        Real* in = Api::alloc_real(n);
+        auto* out = Api::alloc_complex(n / 2 + 1);
+        auto plan = in && out ? plan_r2c<Real>(n, in, out, flags) : nullptr;
+        Api::free(out);
+        Api::free(in);
+        if (plan) {
+            forward.emplace(n, plan);
+        }
+        return plan;
+    }
+};
+
+// Plans every supported window size in both directions and writes the result to the cache file
+template<typename Real = double>
+bool generate(unsigned int flags = FFTW_PATIENT)
+{
+    using Api = Fftw<Real>;
+
+    for (int n : supported_window_sizes) {
+        Real* real = Api::alloc_real(n);
+        auto* spectrum = Api::alloc_complex(n / 2 + 1);
+        if (!real || !spectrum) {
+            Api::free(spectrum);
+            Api::free(real);
+            return false;
+        }
+        auto forward = plan_r2c<Real>(n, real, spectrum, flags);
+        auto inverse = plan_c2r<Real>(n, spectrum, real, flags);
+        bool planned = forward && inverse;
+        if (forward) {
+            Api::destroy(forward);
+        }
+        if (inverse) {
+            Api::destroy(inverse);
+        }
+        Api::free(spectrum);
+        Api::free(real);
+        if (!planned) {
+            return false;
+        }
+    }
+    return save<Real>();
+}
+
+// Loads wisdom for the lifetime of the object and exports it again on destruction
+template<typename Real = double>
+class Session {
+public:
+    Session() : loaded(load<Real>()) {}
+    ~Session() { save<Real>(); }
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    bool was_loaded() const { return loaded; }
+
+private:
+    bool loaded;
+};
+
+} // namespace fft_wisdom
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <fftw3.h>
+
+// Maps a sample type onto the matching FFTW API: fftw_* for double, fftwf_* for float.
+// Only the precision a program actually uses has to be linked (-lfftw3 / -lfftw3f).
+template<typename Real>
+struct Fftw;
+
+template<>
+struct Fftw<double> {
+    using complex = fftw_complex;
+    using plan = fftw_plan;
+
+    static constexpr std::string_view wisdom_file = "fftw.wisdom";
+
+    static double* alloc_real(size_t n) { return fftw_alloc_real(n); }
+    static complex* alloc_complex(size_t n) { return fftw_alloc_complex(n); }
+    static void free(void* p) { fftw_free(p); }
+
+    static plan plan_r2c(int n, double* in, complex* out, unsigned int flags) { return fftw_plan_dft_r2c_1d(n, in, out, flags); }
+    static plan plan_c2r(int n, complex* in, double* out, unsigned int flags) { return fftw_plan_dft_c2r_1d(n, in, out, flags); }
+    static void execute(plan p) { fftw_execute(p); }
+    static void execute_r2c(plan p, double* in, complex* out) { fftw_execute_dft_r2c(p, in, out); }
+    static void execute_c2r(plan p, complex* in, double* out) { fftw_execute_dft_c2r(p, in, out); }
+    static void destroy(plan p) { fftw_destroy_plan(p); }
+
+    static bool import_wisdom(const char* path) { return fftw_import_wisdom_from_filename(path) != 0; }
+    static bool export_wisdom(const char* path) { return fftw_export_wisdom_to_filename(path) != 0; }
+};
+
+template<>
+struct Fftw<float> {
+    using complex = fftwf_complex;
+    using plan = fftwf_plan;
+
+    static constexpr std::string_view wisdom_file = "fftwf.wisdom";
+
+    static float* alloc_real(size_t n) { return fftwf_alloc_real(n); }
+    static complex* alloc_complex(size_t n) { return fftwf_alloc_complex(n); }
+    static void free(void* p) { fftwf_free(p); }
+
+    static plan plan_r2c(int n, float* in, complex* out, unsigned int flags) { return fftwf_plan_dft_r2c_1d(n, in, out, flags); }
+    static plan plan_c2r(int n, complex* in, float* out, unsigned int flags) { return fftwf_plan_dft_c2r_1d(n, in, out, flags); }
+    static void execute(plan p) { fftwf_execute(p); }
+    static void execute_r2c(plan p, float* in, complex* out) { fftwf_execute_dft_r2c(p, in, out); }
+    static void execute_c2r(plan p, complex* in, float* out) { fftwf_execute_dft_c2r(p, in, out); }
+    static void destroy(plan p) { fftwf_destroy_plan(p); }
+
+    static bool import_wisdom(const char* path) { return fftwf_import_wisdom_from_filename(path) != 0; }
+    static bool export_wisdom(const char* path) { return fftwf_export_wisdom_to_filename(path) != 0; }
+};
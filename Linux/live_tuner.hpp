@@ -0,0 +1,538 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <portaudio.h>
+#include "adaptive_window.hpp"
+#include "allocation_guard.hpp"
+#include "arena.hpp"
+#include "audio_device.hpp"
+#include "decimator.hpp"
+#include "event_loop.hpp"
+#include "logger.hpp"
+#include "note_gate.hpp"
+#include "note_mapping.hpp"
+#include "osc_sender.hpp"
+#include "pitch_tracker.hpp"
+#include "realtime.hpp"
+#include "scope_exit.hpp"
+#include "shared_results.hpp"
+#include "sliding_window.hpp"
+#include "snapshot.hpp"
+#include "spsc_ring.hpp"
+#include "telemetry.hpp"
+#include "tuner_analysis.hpp"
+#include "tuner_error.hpp"
+#include "tuner_settings.hpp"
+#ifndef TUNER_HEADLESS
+#include "tuner_display.hpp"
+#endif
+
+// Main tuner class using modern C++ features.
+// Built with -DTUNER_HEADLESS it has no display and always runs as a daemon.
+class GuitarTuner {
+    // Everything one input channel needs. Channels share no mutable state, so each
+    // is analyzed by exactly one worker without locking, using its own FFTW plans.
+    // The ring holds device-rate samples; the frames, after decimation, analysis-rate ones.
+    // All their buffers come from the channel's arena, declared first so it outlives them.
+    struct Channel {
+        Arena arena;
+        SpscRing<float> ring;
+        SlidingWindow<float> frames;
+        std::pmr::vector<float> hop;        // one hop at the device rate
+        Decimator decimator;
+        std::pmr::vector<float> decimated;  // one hop at the analysis rate
+        AudioBuffer<Sample> buffer;
+        std::unique_ptr<PitchDetector<Sample>> detector;    // null in strum mode
+        AdaptiveWindow<Sample>* adaptive;                   // the detector, with --adaptive-window
+        std::unique_ptr<StrumAnalyzer<Sample>> strum;       // strum mode only
+        NoteGate gate;
+        PitchTracker pitch;         // smooths the detector's estimates between onsets
+        Snapshot<TunerReading> latest;
+        Snapshot<StrumReading> strings;
+        
+        Channel(const TunerSettings& settings, double analysis_rate) :
+            ring(std::max(settings.buffer_size, settings.window_size * settings.decimation) * 4, &arena),
+            frames(settings.window_size, settings.hop_size, &arena),
+            hop(settings.hop_size * settings.decimation, &arena),
+            decimator(settings.decimation, analysis_rate, &arena),
+            decimated(settings.hop_size, &arena),
+            buffer(std::is_same_v<Sample, float> ? 0 : settings.window_size, &arena),
+            detector(settings.strum_preset ? nullptr : make_detector(settings, analysis_rate, &arena)),
+            adaptive(dynamic_cast<AdaptiveWindow<Sample>*>(detector.get())),
+            strum(make_strum_analyzer(settings, analysis_rate, &arena)),
+            gate(settings.hop_size, analysis_rate, MIN_AMPLITUDE) {
+            // Nothing grows after this, so the rest of the reservation goes back
+            arena.seal();
+        }
+        
+        // The newest hop, filtered and downsampled when decimating
+        std::span<const float> analysis_hop() {
+            if (decimator.factor() == 1) {
+                return hop;
+            }
+            return std::span(decimated).first(decimator.process(hop, decimated));
+        }
+    };
+    
+    TunerSettings settings;
+    NoteMapper mapper;
+#ifndef TUNER_HEADLESS
+    std::optional<TunerDisplay> display;    // none in daemon mode, so no terminal is needed
+#endif
+    std::optional<SharedResults> shared;    // --shm / --daemon
+    std::optional<OscSender> osc;           // --osc
+    std::optional<EventLoop> events;        // the main thread's wait; made before any other thread
+    telemetry::Stats stats;
+    std::vector<std::unique_ptr<Channel>> channels;
+    double device_rate = 0.0;   // as opened; the callback's deadline is based on it
+    bool audio_promoted = false;            // callback thread only
+    std::atomic<int> audio_rt_error{0};     // reported by the main thread at shutdown
+    std::atomic<bool> running{true};
+    std::vector<std::jthread> workers;
+    
+    // One row per channel, or per string of the strum preset
+    size_t row_count() const {
+        return settings.strum_preset ? TuningConfig::tuning_presets[*settings.strum_preset].strings : channels.size();
+    }
+    
+    static int audio_callback(const void* input_buffer, void* output_buffer,
+                            unsigned long frames_per_buffer,
+                            const PaStreamCallbackTimeInfo* time_info,
+                            PaStreamCallbackFlags status_flags,
+                            void* user_data) {
+        auto* tuner = static_cast<GuitarTuner*>(user_data);
+        return tuner->process_audio(static_cast<const float*>(input_buffer), frames_per_buffer,
+                                    time_info, status_flags);
+    }
+    
+    // Real-time callback: de-interleaves each channel straight into its own queue.
+    // Telemetry is relaxed atomics only, so it never blocks this thread.
+    PaError process_audio(const float* input, size_t frames, const PaStreamCallbackTimeInfo* time_info,
+                          PaStreamCallbackFlags status_flags) {
+        // The callback thread belongs to PortAudio, so it is promoted from its first call
+        if (settings.realtime.enabled && !audio_promoted) {
+            audio_promoted = true;
+            audio_rt_error.store(realtime::promote_audio_thread(settings.realtime), std::memory_order_relaxed);
+        }
+        allocation_guard::NoAllocations real_time;
+        const uint64_t start = telemetry::now_ns();
+        
+        if (status_flags & paInputOverflow) {
+            stats.input_overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (status_flags & paInputUnderflow) {
+            stats.input_underflows.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (time_info && time_info->inputBufferAdcTime > 0.0 && time_info->currentTime >= time_info->inputBufferAdcTime) {
+            stats.input_latency_us.record(static_cast<uint64_t>((time_info->currentTime - time_info->inputBufferAdcTime) * 1e6));
+        }
+        
+        for (size_t c = 0; c < channels.size(); ++c) {
+            channels[c]->ring.push_strided(input + c, frames, channels.size());
+        }
+        stats.queue_depth.record(channels.back()->ring.size());
+        
+        // The next buffer is due one period after this one
+        const uint64_t elapsed = telemetry::now_ns() - start;
+        const double period_ns = frames * 1e9 / device_rate;
+        stats.callback_ns.record(elapsed);
+        stats.deadline_permille.record(static_cast<uint64_t>(elapsed * 1000.0 / period_ns));
+        stats.callbacks.fetch_add(1, std::memory_order_relaxed);
+        return paContinue;
+    }
+    
+    uint64_t dropped_samples() const {
+        uint64_t dropped = 0;
+        for (const auto& channel : channels) {
+            dropped += channel->ring.dropped_count();
+        }
+        return dropped;
+    }
+    
+    // Appends a JSON line per interval; runs on its own thread so file I/O never
+    // delays rendering, and only reads the relaxed counters
+    void dump_loop(std::stop_token stop) {
+        std::ofstream out(settings.stats_file, std::ios::app);
+        if (!out) {
+            Logger::error("Cannot open stats file {}", settings.stats_file);
+            return;
+        }
+        std::mutex mutex;
+        std::condition_variable_any wake;
+        std::unique_lock lock(mutex);
+        while (!stop.stop_requested()) {
+            wake.wait_for(lock, stop, std::chrono::milliseconds(settings.stats_interval_ms), [] { return false; });
+            out << stats.to_json(dropped_samples()) << '\n' << std::flush;
+        }
+    }
+    
+    // Worker `worker` of `worker_count` owns channels worker, worker + worker_count, ...
+    void analysis_loop(std::stop_token stop, size_t worker, size_t worker_count) {
+        if (settings.realtime.enabled) {
+            if (int error = realtime::promote_analysis_thread(settings.realtime, worker)) {
+                Logger::log("Analysis worker {} runs without real-time scheduling: {}", worker, std::strerror(error));
+            }
+        }
+        // First-touched by the planning thread; move them next to this one. A machine
+        // with a single node has nothing to move, so the result does not matter.
+        for (size_t c = worker; c < channels.size(); c += worker_count) {
+            channels[c]->arena.bind_local();
+        }
+        
+        // The callback fills the queues in channel order, so once the last owned
+        // channel has a hop queued, every other owned channel has one as well
+        size_t last = worker;
+        while (last + worker_count < channels.size()) {
+            last += worker_count;
+        }
+        SpscRing<float>& wake_ring = channels[last]->ring;
+        std::stop_callback wake_on_stop(stop, [&wake_ring] { wake_ring.wake(); });
+        
+        const size_t hop_samples = settings.hop_size * settings.decimation;
+        while (wake_ring.wait_for(hop_samples, stop)) {
+            allocation_guard::NoAllocations real_time;
+            for (size_t c = worker; c < channels.size(); c += worker_count) {
+                Channel& channel = *channels[c];
+                
+                auto publish = [&](auto window) {
+                    if (channel.strum) {
+                        if (auto readings = analyze_strum(*channel.strum, channel.buffer, mapper, channel.gate, window, &stats)) {
+                            channel.strings.publish(*readings);
+                            for (size_t s = 0; shared && s < row_count(); ++s) {
+                                shared->publish(s, (*readings)[s].to_shared());
+                            }
+                            if (!settings.daemon) {
+                                events->notify();
+                            }
+                        }
+                        return;
+                    }
+                    
+                    // Raw estimates are smoothed per note; a new onset starts a new track.
+                    // The track picks the adaptive window for the following hops.
+                    auto reading = analyze_window(*channel.detector, channel.buffer, mapper, channel.gate, window, &stats);
+                    if (channel.gate.onset()) {
+                        channel.pitch.reset();
+                        if (channel.adaptive) {
+                            channel.adaptive->reset();
+                        }
+                    }
+                    if (reading) {
+                        const auto estimate = channel.pitch.update(reading->frequency);
+                        if (channel.adaptive) {
+                            channel.adaptive->adapt(estimate.frequency, channel.pitch.window_hint());
+                        }
+                        const TunerReading smoothed{estimate.frequency, mapper.nearest(estimate.frequency), estimate.confidence};
+                        channel.latest.publish(smoothed);
+                        if (shared) {
+                            shared->publish(c, smoothed.to_shared());
+                        }
+                        if (!settings.daemon) {
+                            events->notify();
+                        }
+                    }
+                };
+                
+                // Every hop of new samples completes another overlapping window
+                while (channel.ring.size() >= hop_samples) {
+                    channel.ring.pop(channel.hop);
+                    channel.frames.push(channel.analysis_hop(), publish);
+                }
+            }
+        }
+    }
+    
+    // Feeds remote displays at osc_rate: one OSC message per row that changed since the
+    // last send, and the shared segment's heartbeat. Reads only the snapshots, like the UI.
+    void remote_loop(std::stop_token stop) {
+        const auto period = std::chrono::microseconds(1'000'000 / settings.osc_rate);
+        std::vector<uint64_t> sent_versions(channels.size(), 0);
+        auto send = [&](size_t row, const TunerReading& reading) {
+            if (reading.note.is_valid()) {
+                osc->send_reading(row, std::format("{}{}", NoteMapper::name(reading.note), reading.note.octave),
+                                  reading.frequency, reading.note.cents, reading.confidence);
+            }
+        };
+        
+        std::mutex mutex;
+        std::condition_variable_any wake;
+        std::unique_lock lock(mutex);
+        while (!stop.stop_requested()) {
+            wake.wait_for(lock, stop, period, [] { return false; });
+            if (shared) {
+                shared->heartbeat(telemetry::now_ns());
+            }
+            if (!osc) {
+                continue;
+            }
+            if (settings.strum_preset) {
+                if (auto version = channels[0]->strings.version(); version != sent_versions[0]) {
+                    sent_versions[0] = version;
+                    const StrumReading strings = channels[0]->strings.load();
+                    for (size_t s = 0; s < row_count(); ++s) {
+                        send(s, strings[s]);
+                    }
+                }
+                continue;
+            }
+            for (size_t c = 0; c < channels.size(); ++c) {
+                if (auto version = channels[c]->latest.version(); version != sent_versions[c]) {
+                    sent_versions[c] = version;
+                    send(c, channels[c]->latest.load());
+                }
+            }
+        }
+    }
+    
+    // Wakes every analysis worker and waits for it to leave its loop
+    void stop_workers() {
+        for (auto& worker : workers) {
+            worker.request_stop();
+        }
+        workers.clear();
+    }
+    
+#ifndef TUNER_HEADLESS
+    // UI thread: sleeps in the event loop until a result is published, a key is pressed
+    // or a signal arrives, so results are drawn the moment they exist and nothing runs
+    // during silence. At most max_fps frames are drawn a second: a result arriving
+    // sooner waits out the frame, and everything published meanwhile is drawn at once
+    // from the latest snapshots. 's' toggles the telemetry pane, which adds a refresh
+    // about twice a second while it is shown.
+    void render_loop() {
+        using Clock = std::chrono::steady_clock;
+        const auto frame_period = std::chrono::nanoseconds(1'000'000'000 / settings.max_fps);
+        const auto stats_period = std::chrono::milliseconds(500);
+        std::vector<uint64_t> rendered_versions(channels.size(), 0);
+        std::vector<TunerReading> readings(channels.size());
+        bool show_stats = false;
+        bool pending = false;       // a published result is not drawn yet
+        auto last_frame = Clock::now() - frame_period;
+        auto next_stats = Clock::now();
+        while (running) {
+            // Wake for the next frame only with a result waiting, for the pane only while shown
+            int timeout_ms = -1;
+            if (pending || show_stats) {
+                auto deadline = pending ? last_frame + frame_period : next_stats;
+                if (pending && show_stats) {
+                    deadline = std::min(deadline, next_stats);
+                }
+                const auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+                timeout_ms = static_cast<int>(std::max<int64_t>(wait.count(), 0));
+            }
+            const EventLoop::Events ready = events->wait(timeout_ms);
+            if (ready.signal) {
+                break;
+            }
+            pending |= ready.result;
+            
+            bool redraw = false;
+            if (ready.input) {
+                for (int ch = display->poll_key(); ch != ERR; ch = display->poll_key()) {
+                    if (ch == 'q' || ch == 'Q') {
+                        running = false;
+                    } else if (ch == 's' || ch == 'S') {
+                        show_stats = !show_stats;
+                        display->show_stats(show_stats);
+                        next_stats = Clock::now();
+                        redraw = true;
+                    }
+                }
+            }
+            
+            const auto now = Clock::now();
+            const uint64_t render_start = telemetry::now_ns();
+            if (pending && now >= last_frame + frame_period) {
+                pending = false;
+                last_frame = now;
+                if (settings.strum_preset) {
+                    // Strum mode runs on one channel and publishes all strings together
+                    if (auto version = channels[0]->strings.version(); version != rendered_versions[0]) {
+                        rendered_versions[0] = version;
+                        const StrumReading strings = channels[0]->strings.load();
+                        display->update_strings(std::span(strings).first(row_count()));
+                    }
+                } else {
+                    bool changed = false;
+                    for (size_t c = 0; c < channels.size(); ++c) {
+                        if (auto version = channels[c]->latest.version(); version != rendered_versions[c]) {
+                            rendered_versions[c] = version;
+                            readings[c] = channels[c]->latest.load();
+                            changed = true;
+                        }
+                    }
+                    if (changed && channels.size() == 1) {
+                        display->update(readings[0]);
+                    } else if (changed) {
+                        display->update_channels(readings);
+                    }
+                }
+                redraw = true;
+            }
+            if (show_stats && now >= next_stats) {
+                display->update_stats(stats, dropped_samples());
+                next_stats = now + stats_period;
+                redraw = true;
+            }
+            if (redraw && display->present()) {
+                stats.render_ns.record(telemetry::now_ns() - render_start);
+            }
+        }
+    }
+#endif
+    
+public:
+    explicit GuitarTuner(const TunerSettings& tuner_settings) :
+        settings(tuner_settings),
+        mapper(settings.a4_hz) {}
+    
+    Result<void> run() {
+        PaStream* stream;
+        
+        // SIGINT and SIGTERM are blocked here, before any thread is started (PortAudio's
+        // included), so they reach the event loop alone and the terminal is restored
+        events.emplace(!settings.daemon);
+        if (!events->is_valid()) {
+            return std::unexpected(TunerError(std::format("Cannot create the event loop: {}", std::strerror(errno))));
+        }
+        
+        if (auto error = Pa_Initialize(); error != paNoError) {
+            return std::unexpected(TunerError(Pa_GetErrorText(error)));
+        }
+        
+        ScopeExit cleanup([] {
+            Pa_Terminate();
+        });
+        
+        const audio_device::InputRequest request{settings.device, static_cast<int>(settings.channels),
+                                                 settings.sample_rate, settings.latency_ms};
+        audio_device::OpenedInput input;
+        if (auto error = audio_device::open_input(request, settings.buffer_size, audio_callback, this, &stream, &input);
+            error != paNoError) {
+            return std::unexpected(TunerError(settings.device.empty()
+                ? std::format("Cannot open the default input: {}", Pa_GetErrorText(error))
+                : std::format("Cannot open input \"{}\": {}", settings.device, Pa_GetErrorText(error))));
+        }
+        
+        ScopeExit stream_cleanup([&] {
+            Pa_CloseStream(stream);
+        });
+        
+        // Everything is planned for the rate the device actually runs at. The FFTW
+        // planner is not thread-safe, so every channel is planned here, before any
+        // worker starts; executing the plans concurrently is safe.
+        device_rate = input.sample_rate;
+        const double analysis_rate = device_rate / settings.decimation;
+        channels.reserve(settings.channels);
+        for (size_t c = 0; c < settings.channels; ++c) {
+            channels.push_back(std::make_unique<Channel>(settings, analysis_rate));
+            Logger::debug("Channel {}: {} KiB of analysis state", c, channels.back()->arena.bytes_used() / 1024);
+        }
+        
+        const PaDeviceInfo* info = Pa_GetDeviceInfo(input.device);
+        auto title = std::format("{} [{}] {:g} Hz, {:.1f} ms", info && info->name ? info->name : "?",
+                                 info ? audio_device::host_api_name(*info) : "?", device_rate, input.latency_ms);
+        if (settings.decimation > 1) {
+            title += std::format(", analysis at {:g} Hz", analysis_rate);
+        }
+        if (!settings.shm_name.empty()) {
+            auto segment = SharedResults::create(settings.shm_name,
+                settings.strum_preset ? SharedLayout::strings : SharedLayout::channels, row_count(), device_rate,
+                settings.a4_hz);
+            if (!segment) {
+                return std::unexpected(segment.error());
+            }
+            shared = std::move(*segment);
+        }
+        if (!settings.osc_target.empty()) {
+            auto sender = OscSender::open(settings.osc_target);
+            if (!sender) {
+                return std::unexpected(sender.error());
+            }
+            osc = std::move(*sender);
+        }
+        if (settings.daemon) {
+            Logger::log("{}{}", title, shared ? std::format(", publishing to {}", shared->name()) : "");
+        }
+#ifndef TUNER_HEADLESS
+        if (!settings.daemon) {
+            display.emplace();
+            display->set_title(std::move(title));
+        }
+#endif
+        
+        // Everything the stream touches exists now: lock it in RAM, faulting it all in
+        if (settings.realtime.enabled) {
+            if (int error = realtime::lock_memory()) {
+                Logger::log("Memory is not locked, page faults may delay the analysis: {}", std::strerror(error));
+            }
+        }
+        
+        // Channels are independent, so throughput scales with the worker count
+        size_t worker_count = settings.workers ? settings.workers : std::max(1u, std::thread::hardware_concurrency());
+        worker_count = std::min(worker_count, channels.size());
+        for (size_t w = 0; w < worker_count; ++w) {
+            workers.emplace_back([this, w, worker_count](std::stop_token stop) { analysis_loop(stop, w, worker_count); });
+        }
+        
+        std::jthread dump_thread;
+        if (!settings.stats_file.empty()) {
+            dump_thread = std::jthread([this](std::stop_token stop) { dump_loop(stop); });
+        }
+        std::jthread remote_thread;
+        if (shared || osc) {
+            remote_thread = std::jthread([this](std::stop_token stop) { remote_loop(stop); });
+        }
+        
+        // The caller logs the error, so the terminal is given back before returning
+        if (auto error = Pa_StartStream(stream); error != paNoError) {
+            stop_workers();
+            dump_thread = {};
+            remote_thread = {};
+#ifndef TUNER_HEADLESS
+            display.reset();
+#endif
+            return std::unexpected(TunerError(std::format("Cannot start the input: {}", Pa_GetErrorText(error))));
+        }
+        
+#ifndef TUNER_HEADLESS
+        if (!settings.daemon) {
+            render_loop();
+        }
+#endif
+        if (settings.daemon) {
+            int signal = 0;
+            while (!(signal = events->wait().signal)) {
+            }
+            Logger::log("Stopping on {}", strsignal(signal));
+        }
+        
+        Pa_StopStream(stream);
+        stop_workers();
+        dump_thread = {};
+        remote_thread = {};
+        if (int error = audio_rt_error.load(std::memory_order_relaxed)) {
+            Logger::log("The audio callback ran without real-time scheduling: {}", std::strerror(error));
+        }
+        
+        return {};
+    }
+};
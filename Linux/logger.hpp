@@ -0,0 +1,225 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <source_location>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+// Levels below TUNER_LOG_LEVEL are removed at compile time: 0 debug, 1 info, 2 error.
+// Per-frame diagnostics go to Logger::debug, which costs nothing in a default build.
+#ifndef TUNER_LOG_LEVEL
+#define TUNER_LOG_LEVEL 1
+#endif
+
+enum class LogLevel { debug, info, error };
+
+inline constexpr LogLevel min_log_level = static_cast<LogLevel>(TUNER_LOG_LEVEL);
+
+namespace log_detail {
+
+// One formatted line; longer messages are truncated
+struct Record {
+    int64_t time_ns = 0;    // system clock
+    uint32_t length = 0;
+    std::array<char, 244> text{};
+};
+
+// Bounded lock-free multi-producer/single-consumer queue (Vyukov). Each slot carries a
+// sequence number that tells producers and the consumer whose turn it is, so a push
+// is one CAS plus a copy and never waits for another thread.
+template<typename T, size_t N>
+    requires (std::has_single_bit(N))
+class MpscQueue {
+    static constexpr size_t cache_line = 64;
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::array<Slot, N> slots;
+    alignas(cache_line) std::atomic<size_t> enqueue_pos{0};
+    alignas(cache_line) size_t dequeue_pos = 0;     // owned by the consumer
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < N; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Producer side; false if the queue is full
+    bool try_push(const T& value) noexcept {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & (N - 1)];
+            const size_t seq = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::make_signed_t<size_t>>(seq - pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer side; false if nothing is ready
+    bool try_pop(T& out) noexcept {
+        Slot& slot = slots[dequeue_pos & (N - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) {
+            return false;
+        }
+        out = slot.value;
+        slot.sequence.store(dequeue_pos + N, std::memory_order_release);
+        ++dequeue_pos;
+        return true;
+    }
+};
+
+// Background writer that owns the only stream output. The time zone is looked up
+// once; producers only take a clock reading, format into their thread's record and
+// enqueue it.
+class Sink {
+    MpscQueue<Record, 512> queue;
+    std::atomic<uint32_t> signal{0};
+    std::atomic<uint64_t> dropped{0};
+    const std::chrono::time_zone* zone = std::chrono::current_zone();
+    std::jthread writer;    // last member: stopped, after a final drain, before the queue goes away
+
+    // "[HH:MM:SS.mmm] ", from the cached zone
+    size_t format_time(int64_t time_ns, char* out) const {
+        using namespace std::chrono;
+        const auto local = zone->to_local(sys_time<milliseconds>(milliseconds(time_ns / 1'000'000)));
+        const hh_mm_ss clock(local - floor<days>(local));
+        const auto result = std::format_to_n(out, 16, "[{:02}:{:02}:{:02}.{:03}] ",
+            clock.hours().count(), clock.minutes().count(), clock.seconds().count(), clock.subseconds().count());
+        return static_cast<size_t>(result.out - out);
+    }
+
+    void drain(std::array<char, 16 + sizeof(Record::text) + 1>& line) {
+        Record record;
+        while (queue.try_pop(record)) {
+            size_t n = format_time(record.time_ns, line.data());
+            std::copy_n(record.text.data(), record.length, line.data() + n);
+            n += record.length;
+            line[n++] = '\n';
+            std::clog.write(line.data(), static_cast<std::streamsize>(n));
+        }
+        if (const uint64_t lost = dropped.exchange(0, std::memory_order_relaxed)) {
+            std::clog << "[logger] " << lost << " messages dropped\n";
+        }
+        std::clog.flush();
+    }
+
+    void run(std::stop_token stop) {
+        std::array<char, 16 + sizeof(Record::text) + 1> line{};
+        std::stop_callback wake(stop, [this] {
+            signal.fetch_add(1, std::memory_order_release);
+            signal.notify_one();
+        });
+        while (!stop.stop_requested()) {
+            const uint32_t seen = signal.load(std::memory_order_acquire);
+            drain(line);
+            signal.wait(seen, std::memory_order_acquire);
+        }
+        drain(line);
+    }
+
+public:
+    Sink() : writer([this](std::stop_token stop) { run(stop); }) {}
+
+    // Producer side; never blocks, and counts the message as dropped if the writer fell behind
+    void submit(const Record& record) noexcept {
+        if (!queue.try_push(record)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+    }
+};
+
+// Constructed on first use and destroyed, after a final drain, at exit
+inline Sink& sink() {
+    static Sink instance;
+    return instance;
+}
+
+inline Record& scratch() {
+    thread_local Record record;
+    return record;
+}
+
+// A format string that remembers where the log call was written
+template<typename... Args>
+struct LocatedFormat {
+    std::format_string<Args...> format;
+    std::source_location location;
+
+    template<typename S>
+    consteval LocatedFormat(const S& text, std::source_location loc = std::source_location::current())
+        : format(text), location(loc) {}
+};
+
+} // namespace log_detail
+
+// Asynchronous, allocation-free logging to stderr, so offline results on stdout stay
+// clean. Messages are formatted on the calling thread into a reused per-thread record
+// and written out by a background thread; a disabled level compiles to nothing
+// (its arguments are still evaluated).
+class Logger {
+    template<LogLevel Level, typename... Args>
+    static void write(std::string_view prefix, std::format_string<Args...> fmt, Args&&... args) {
+        if constexpr (Level >= min_log_level) {
+            auto& record = log_detail::scratch();
+            record.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+            char* const begin = record.text.data();
+            const auto capacity = static_cast<std::ptrdiff_t>(record.text.size());
+            const auto head = std::format_to_n(begin, capacity, "{}", prefix);
+            const auto body = std::format_to_n(head.out, capacity - (head.out - begin), fmt, std::forward<Args>(args)...);
+            record.length = static_cast<uint32_t>(body.out - begin);
+
+            log_detail::sink().submit(record);
+        }
+    }
+
+public:
+    template<typename... Args>
+    static void debug(std::format_string<Args...> fmt, Args&&... args) {
+        write<LogLevel::debug>("", fmt, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    static void log(std::format_string<Args...> fmt, Args&&... args) {
+        write<LogLevel::info>("", fmt, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    static void error(log_detail::LocatedFormat<std::type_identity_t<Args>...> fmt, Args&&... args) {
+        if constexpr (LogLevel::error >= min_log_level) {
+            // "Error at file:line - " is formatted into a stack buffer, not a string
+            std::array<char, 96> prefix{};
+            const auto located = std::format_to_n(prefix.data(), prefix.size() - 1, "Error at {}:{} - ",
+                fmt.location.file_name(), fmt.location.line());
+            write<LogLevel::error>(std::string_view(prefix.data(), located.out - prefix.data()),
+                fmt.format, std::forward<Args>(args)...);
+        }
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <memory_resource>
+#include <vector>
+#include "correlation.hpp"
+#include "pitch_detector.hpp"
+
+// McLeod Pitch Method (McLeod & Wyvill, 2005).
+// The normalized square difference function n(tau) = 2 r(tau) / m(tau) is built
+// from an FFT autocorrelation. The pitch lag is the first "key maximum" (the
+// highest point of a positive lobe) that reaches cutoff times the highest one,
+// which avoids locking onto the second harmonic of the low strings.
+template<typename Real = double>
+class MpmDetector : public PitchDetector<Real> {
+    size_t window_size;
+    double sample_rate;
+    double cutoff;
+    size_t min_lag;
+    size_t max_lag;
+    Correlator<Real> correlator;
+    std::pmr::vector<Real> correlation;
+    std::pmr::vector<double> nsdf;
+    
+public:
+    static constexpr double min_clarity = 0.5;
+    
+    MpmDetector(size_t size, double rate, double key_cutoff = 0.93,
+                double min_frequency = 60.0, double max_frequency = 1500.0,
+                std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        window_size(size),
+        sample_rate(rate),
+        cutoff(key_cutoff),
+        min_lag(std::max<size_t>(2, static_cast<size_t>(rate / max_frequency))),
+        max_lag(std::min(size / 2, static_cast<size_t>(std::ceil(rate / min_frequency)))),
+        correlator(size, memory),
+        correlation(max_lag + 2, memory),
+        nsdf(max_lag + 2, memory) {}
+    
+    std::string_view name() const override { return "mpm"; }
+    
+    size_t size() const override { return window_size; }
+    
+    Result<double> analyze(std::span<const Real> audio_data) override {
+        if (audio_data.size() != window_size) {
+            return std::unexpected(TunerError("Invalid audio buffer size"));
+        }
+        
+        correlator.autocorrelate(audio_data, correlation);
+        
+        // m(tau) = sum over the overlap of x[j]^2 + x[j + tau]^2, updated incrementally
+        double m = 0.0;
+        for (const Real x : audio_data) {
+            m += 2.0 * x * x;
+        }
+        nsdf[0] = m > 0.0 ? 1.0 : 0.0;
+        for (size_t tau = 1; tau < nsdf.size(); ++tau) {
+            const double head = audio_data[tau - 1];
+            const double tail = audio_data[window_size - tau];
+            m -= head * head + tail * tail;
+            nsdf[tau] = m > 0.0 ? 2.0 * correlation[tau] / m : 0.0;
+        }
+        
+        // Highest key maximum, ignoring the lobe around lag zero
+        auto for_each_key_maximum = [&](auto&& visit) {
+            size_t tau = 1;
+            while (tau <= max_lag && nsdf[tau] > 0.0) {
+                ++tau;
+            }
+            while (tau <= max_lag) {
+                while (tau <= max_lag && nsdf[tau] <= 0.0) {
+                    ++tau;
+                }
+                size_t peak = tau;
+                while (tau <= max_lag && nsdf[tau] > 0.0) {
+                    if (nsdf[tau] > nsdf[peak]) {
+                        peak = tau;
+                    }
+                    ++tau;
+                }
+                if (peak <= max_lag && peak >= min_lag && visit(peak)) {
+                    return;
+                }
+            }
+        };
+        
+        double highest = 0.0;
+        for_each_key_maximum([&](size_t peak) {
+            highest = std::max(highest, nsdf[peak]);
+            return false;
+        });
+        if (highest < min_clarity) {
+            return std::unexpected(TunerError("No periodic signal found"));
+        }
+        
+        size_t best = 0;
+        for_each_key_maximum([&](size_t peak) {
+            best = peak;
+            return nsdf[peak] >= cutoff * highest;
+        });
+        
+        // Parabolic interpolation around the key maximum
+        const double a = nsdf[best - 1];
+        const double b = nsdf[best];
+        const double c = nsdf[best + 1];
+        const double denom = a - 2.0 * b + c;
+        const double lag = denom < 0.0 ? best + 0.5 * (a - c) / denom : static_cast<double>(best);
+        
+        return sample_rate / lag;
+    }
+};
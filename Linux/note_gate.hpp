@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include "simd_kernels.hpp"
+
+// Adaptive noise gate with onset detection, driven by the energy envelope of each
+// new hop of samples. The noise floor starts at the absolute minimum, falls to a
+// quieter level at once and rises towards a louder one over several seconds (much
+// more slowly while a note rings), so a fan or an amplifier's hiss raises the
+// threshold instead of being analyzed. A hop that jumps well above the floor, or well
+// above the hop before it while a note rings, is an onset. The pick attack that
+// follows is skipped, being broadband noise more than pitch, and every hop is
+// analyzed from then on until the note decays back towards the floor. In silence
+// only the envelope is computed.
+enum class GateState { silent, attack, sustain };
+
+class NoteGate {
+    static constexpr double OPEN_DB = 12.0;     // onset from silence: this far above the floor
+    static constexpr double CLOSE_DB = 6.0;     // a note closes this close to the floor
+    static constexpr double ONSET_DB = 6.0;     // re-pluck: rise over the previous hop
+    static constexpr double ATTACK_S = 0.03;    // skipped after each onset
+    static constexpr double FLOOR_RISE_S = 5.0; // time constant of a rising floor in silence
+    static constexpr double NOTE_FLOOR_RISE_S = 20.0;   // and during a note
+
+    size_t hop;
+    double min_db;
+    double rise;            // smoothing factors of a rising floor, per hop
+    double note_rise;
+    size_t attack_hops;
+    double floor_db;
+    double previous_db = -INFINITY;
+    GateState current = GateState::silent;
+    size_t attack_left = 0;
+    bool onset_seen = false;
+
+    static double energy_db(std::span<const float> hop) {
+        const double rms = simd::rms(hop);
+        return 20.0 * std::log10(std::max(rms, 1e-9));
+    }
+
+public:
+    // hop_size: new samples per update; min_rms: always silence below it
+    NoteGate(size_t hop_size, double sample_rate, double min_rms) :
+        hop(std::max<size_t>(hop_size, 1)),
+        min_db(20.0 * std::log10(min_rms)),
+        rise(std::min(1.0, hop / sample_rate / FLOOR_RISE_S)),
+        note_rise(std::min(1.0, hop / sample_rate / NOTE_FLOOR_RISE_S)),
+        attack_hops(static_cast<size_t>(std::ceil(ATTACK_S * sample_rate / hop))),
+        floor_db(min_db) {}
+
+    GateState state() const noexcept { return current; }
+
+    // The last update started a note
+    bool onset() const noexcept { return onset_seen; }
+
+    double noise_floor_db() const noexcept { return floor_db; }
+
+    // Classifies the newest hop of a window (or a whole frame, when frames do not
+    // overlap); true if the window should be analyzed
+    bool update(std::span<const float> window) {
+        const double level = energy_db(window.last(std::min(hop, window.size())));
+        const double rise_db = level - previous_db;
+        previous_db = level;
+
+        // The floor follows quiet hops down immediately, to no less than the minimum;
+        // a rising one is smoothed
+        if (level < floor_db) {
+            floor_db = std::max(level, min_db);
+        } else {
+            floor_db += (current == GateState::silent ? rise : note_rise) * (level - floor_db);
+        }
+
+        onset_seen = level > min_db
+                  && (current == GateState::silent ? level > floor_db + OPEN_DB : rise_db > ONSET_DB);
+        if (onset_seen) {
+            current = GateState::attack;
+            attack_left = attack_hops;
+        }
+
+        if (current != GateState::silent && (level <= min_db || level < floor_db + CLOSE_DB)) {
+            current = GateState::silent;
+        }
+        if (current == GateState::attack) {
+            if (attack_left > 0) {
+                --attack_left;
+                return false;
+            }
+            current = GateState::sustain;
+        }
+        return current == GateState::sustain;
+    }
+};
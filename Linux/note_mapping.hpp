@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <string_view>
+#include "tunings.hpp"
+
+// Closed-form equal-temperament note lookup.
+// The nearest semitone is round(12 * log2(f / A4)), so a lookup costs one log2 and
+// one read of the compile-time frequency table, with no scan and no allocation.
+struct NoteMatch {
+    int note_index = -1;    // 0 = C ... 11 = B, -1 if the frequency was not positive
+    int octave = 0;         // scientific pitch notation, A4 = 440 Hz by default
+    double target_hz = 0.0; // frequency of the matched note
+    double cents = 0.0;     // deviation from the target, in [-50, 50]
+
+    constexpr bool is_valid() const { return note_index >= 0; }
+};
+
+class NoteMapper {
+    double a4_hz;
+
+public:
+    static constexpr std::array<std::string_view, 12> note_names = {
+        "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
+    };
+
+    static constexpr double default_a4_hz = 440.0;
+
+    constexpr explicit NoteMapper(double a4 = default_a4_hz) : a4_hz(a4) {}
+
+    constexpr double reference() const { return a4_hz; }
+
+    NoteMatch nearest(double frequency) const noexcept {
+        if (!(frequency > 0.0)) {
+            return {};
+        }
+
+        const double semitones = 12.0 * std::log2(frequency / a4_hz);
+        const double nearest_semitone = std::round(semitones);
+
+        // MIDI numbering: A4 = 69, C4 = 60
+        const int midi = 69 + static_cast<int>(nearest_semitone);
+        const int octave = (midi >= 0 ? midi / 12 : (midi - 11) / 12) - 1;
+
+        return NoteMatch{
+            midi - (octave + 1) * 12,
+            octave,
+            midi >= 0 && midi < static_cast<int>(tunings::equal_temperament.size())
+                ? tunings::equal_temperament[midi] * (a4_hz / 440.0)
+                : a4_hz * std::exp2(nearest_semitone / 12.0),
+            100.0 * (semitones - nearest_semitone)
+        };
+    }
+
+    static constexpr std::string_view name(const NoteMatch& match) {
+        return match.is_valid() ? note_names[match.note_index] : std::string_view("-");
+    }
+};
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "adaptive_window.hpp"
+#include "decimator.hpp"
+#include "logger.hpp"
+#include "note_gate.hpp"
+#include "note_mapping.hpp"
+#include "pcm_input.hpp"
+#include "pitch_tracker.hpp"
+#include "sliding_window.hpp"
+#include "tuner_analysis.hpp"
+#include "tuner_error.hpp"
+#include "tuner_settings.hpp"
+
+// Headless analysis of recordings, as fast as the cores allow.
+// Every hop of every channel becomes one CSV row on stdout; files are spread over a
+// worker pool, and each file is memory-mapped rather than read.
+class OfflineAnalyzer {
+    static constexpr size_t CHUNK_FRAMES = 4096;
+    
+    // Per-worker state, reused from one file to the next
+    struct Worker {
+        // By sample rate and channel, as a string tracker follows a single signal
+        std::map<std::pair<double, size_t>, std::unique_ptr<PitchDetector<Sample>>> detectors;
+        std::map<double, std::unique_ptr<StrumAnalyzer<Sample>>> strummers;    // by sample rate
+        AudioBuffer<Sample> buffer;
+        std::vector<float> samples;
+        std::vector<float> decimated;
+        std::string rows;
+        
+        explicit Worker(size_t window_size) : buffer(std::is_same_v<Sample, float> ? 0 : window_size) {}
+    };
+    
+    TunerSettings settings;
+    NoteMapper mapper;
+    std::mutex planner_mutex;   // the FFTW planner is not thread-safe
+    std::mutex output_mutex;    // each file's rows are written in one piece
+    
+    PitchDetector<Sample>& detector_for(Worker& worker, double sample_rate, size_t channel) {
+        auto& detector = worker.detectors[{sample_rate, channel}];
+        if (!detector) {
+            std::lock_guard lock(planner_mutex);
+            detector = make_detector(settings, sample_rate);
+        }
+        return *detector;
+    }
+    
+    StrumAnalyzer<Sample>& strum_for(Worker& worker, double sample_rate) {
+        auto& strum = worker.strummers[sample_rate];
+        if (!strum) {
+            std::lock_guard lock(planner_mutex);
+            strum = make_strum_analyzer(settings, sample_rate);
+        }
+        return *strum;
+    }
+    
+    // Feeds a recording chunk by chunk through one sliding window per channel, after
+    // the same decimation as the live input. In strum mode each window gives one row
+    // per sounding string instead. An adaptive window is chosen by a pitch track as it
+    // is live, but the rows keep the raw estimates.
+    template<typename NextChunk>
+    void analyze(Worker& worker, std::string_view name, const PcmFormat& format, NextChunk&& next_chunk) {
+        const double analysis_rate = format.sample_rate / settings.decimation;
+        std::vector<SlidingWindow<float>> frames;
+        std::vector<Decimator> decimators;
+        std::vector<NoteGate> gates;
+        std::vector<PitchDetector<Sample>*> detectors;
+        std::vector<AdaptiveWindow<Sample>*> adaptives;
+        std::vector<PitchTracker> tracks(format.channels);
+        std::vector<size_t> windows(format.channels, 0);
+        for (size_t c = 0; c < format.channels; ++c) {
+            frames.emplace_back(settings.window_size, settings.hop_size);
+            decimators.emplace_back(settings.decimation, analysis_rate);
+            gates.emplace_back(settings.hop_size, analysis_rate, MIN_AMPLITUDE);
+            detectors.push_back(settings.strum_preset ? nullptr : &detector_for(worker, analysis_rate, c));
+            // The detectors are reused from file to file, the note is not
+            adaptives.push_back(dynamic_cast<AdaptiveWindow<Sample>*>(detectors.back()));
+            if (adaptives.back()) {
+                adaptives.back()->reset();
+            }
+        }
+        StrumAnalyzer<Sample>* strum = settings.strum_preset ? &strum_for(worker, analysis_rate) : nullptr;
+        
+        for (auto chunk = next_chunk(); !chunk.empty(); chunk = next_chunk()) {
+            const size_t count = chunk.size() / format.frame_bytes();
+            worker.samples.resize(count);
+            
+            for (size_t c = 0; c < format.channels; ++c) {
+                decode_channel(format, chunk.data(), count, c, worker.samples);
+                std::span<const float> samples = worker.samples;
+                if (settings.decimation > 1) {
+                    worker.decimated.resize(decimators[c].output_count(count));
+                    samples = std::span(worker.decimated).first(decimators[c].process(worker.samples, worker.decimated));
+                }
+                frames[c].push(samples, [&](auto window) {
+                    // Timestamp of the newest sample in the window
+                    const double time = (settings.window_size + windows[c]++ * settings.hop_size) / analysis_rate;
+                    auto out = std::back_inserter(worker.rows);
+                    if (strum) {
+                        const auto readings = analyze_strum(*strum, worker.buffer, mapper, gates[c], window).value_or(StrumReading{});
+                        bool any = false;
+                        for (const auto& reading : readings) {
+                            if (reading.note.is_valid()) {
+                                std::format_to(out, "\"{}\",{},{:.4f},{:.3f},{}{},{:+.2f}\n", name, c + 1, time,
+                                    reading.frequency, NoteMapper::name(reading.note), reading.note.octave, reading.note.cents);
+                                any = true;
+                            }
+                        }
+                        if (!any) {
+                            std::format_to(out, "\"{}\",{},{:.4f},,,\n", name, c + 1, time);
+                        }
+                        return;
+                    }
+                    
+                    const auto reading = analyze_window(*detectors[c], worker.buffer, mapper, gates[c], window);
+                    if (adaptives[c]) {
+                        if (gates[c].onset()) {
+                            tracks[c].reset();
+                            adaptives[c]->reset();
+                        }
+                        if (reading) {
+                            adaptives[c]->adapt(tracks[c].update(reading->frequency).frequency, tracks[c].window_hint());
+                        }
+                    }
+                    if (reading) {
+                        std::format_to(out, "\"{}\",{},{:.4f},{:.3f},{}{},{:+.2f}\n", name, c + 1, time,
+                            reading->frequency, NoteMapper::name(reading->note), reading->note.octave, reading->note.cents);
+                    } else {
+                        std::format_to(out, "\"{}\",{},{:.4f},,,\n", name, c + 1, time);
+                    }
+                });
+            }
+        }
+        
+        std::lock_guard lock(output_mutex);
+        std::cout << worker.rows << std::flush;
+        worker.rows.clear();
+    }
+    
+    Result<void> analyze_input(Worker& worker, const std::string& path) {
+        if (path == "-") {
+            auto stream = PcmStream::open(stdin, raw_format(), CHUNK_FRAMES);
+            if (!stream) {
+                return std::unexpected(stream.error());
+            }
+            analyze(worker, "-", stream->format(), [&] { return stream->read(); });
+            return {};
+        }
+        
+        auto file = MappedFile::open(path);
+        if (!file) {
+            return std::unexpected(file.error());
+        }
+        auto view = settings.raw_encoding ? Result<PcmView>(PcmView{*raw_format(), file->bytes()})
+                                          : parse_wav(file->bytes());
+        if (!view) {
+            return std::unexpected(view.error());
+        }
+        
+        const size_t frame = view->format.frame_bytes();
+        const size_t end = view->frames() * frame;
+        size_t offset = 0;
+        analyze(worker, path, view->format, [&] {
+            auto chunk = view->data.subspan(offset, std::min(CHUNK_FRAMES * frame, end - offset));
+            offset += chunk.size();
+            return chunk;
+        });
+        return {};
+    }
+    
+    std::optional<PcmFormat> raw_format() const {
+        if (!settings.raw_encoding) {
+            return std::nullopt;
+        }
+        const double rate = settings.sample_rate > 0.0 ? settings.sample_rate : TunerSettings::default_raw_rate;
+        return PcmFormat{*settings.raw_encoding, settings.channels, rate};
+    }
+    
+    // Expands directories into the recordings they contain, in a stable order
+    Result<std::vector<std::string>> collect_inputs() const {
+        using namespace std::literals;
+        std::vector<std::string> inputs;
+        for (const auto& input : settings.offline_inputs) {
+            std::error_code ec;
+            if (input == "-" || !std::filesystem::is_directory(input, ec)) {
+                inputs.push_back(input);
+                continue;
+            }
+            
+            std::vector<std::string> found;
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(input, ec)) {
+                const auto extension = entry.path().extension();
+                const bool wanted = settings.raw_encoding ? extension == ".raw" || extension == ".pcm"
+                                                          : extension == ".wav" || extension == ".WAV";
+                if (entry.is_regular_file() && wanted) {
+                    found.push_back(entry.path().string());
+                }
+            }
+            if (ec) {
+                return std::unexpected(TunerError(std::format("Cannot list {}: {}", input, ec.message())));
+            }
+            std::ranges::sort(found);
+            std::ranges::move(found, std::back_inserter(inputs));
+        }
+        if (std::ranges::count(inputs, "-"s) > 1) {
+            return std::unexpected(TunerError("stdin can only be analyzed once"));
+        }
+        return inputs;
+    }
+    
+public:
+    explicit OfflineAnalyzer(const TunerSettings& tuner_settings) :
+        settings(tuner_settings),
+        mapper(settings.a4_hz) {}
+    
+    Result<void> run() {
+        auto inputs = collect_inputs();
+        if (!inputs) {
+            return std::unexpected(inputs.error());
+        }
+        
+        std::cout << "file,channel,time_s,frequency_hz,note,cents\n";
+        
+        size_t worker_count = settings.workers ? settings.workers : std::max(1u, std::thread::hardware_concurrency());
+        worker_count = std::clamp<size_t>(worker_count, 1, std::max<size_t>(inputs->size(), 1));
+        
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> failed{0};
+        {
+            std::vector<std::jthread> pool;
+            for (size_t w = 0; w < worker_count; ++w) {
+                pool.emplace_back([&] {
+                    Worker worker(settings.window_size);
+                    for (size_t i; (i = next.fetch_add(1)) < inputs->size();) {
+                        if (auto result = analyze_input(worker, (*inputs)[i]); !result) {
+                            Logger::error("{}: {}", (*inputs)[i], result.error().message);
+                            failed.fetch_add(1);
+                        }
+                    }
+                });
+            }
+        }
+        
+        if (failed > 0) {
+            return std::unexpected(TunerError(std::format("{} of {} inputs could not be analyzed", failed.load(), inputs->size())));
+        }
+        return {};
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "tuner_error.hpp"
+
+// Open Sound Control over UDP, for displays on other machines. Each message is
+//   /tuner/reading ,isfff  row (1-based), note ("A2", "-"), frequency, cents, confidence
+// built in a fixed buffer, so sending costs one sendto and no allocation. A broadcast
+// address reaches every display on the subnet.
+class OscSender {
+    int fd = -1;
+    sockaddr_storage target{};
+    socklen_t target_length = 0;
+
+    OscSender(int socket_fd, const sockaddr* address, socklen_t length) : fd(socket_fd), target_length(length) {
+        std::memcpy(&target, address, length);
+    }
+
+    // OSC packs everything big-endian on 4-byte boundaries
+    class Packet {
+        std::array<char, 128> bytes{};
+        size_t size = 0;
+
+    public:
+        void string(std::string_view text) {
+            const size_t padded = (text.size() + 4) & ~size_t{3};  // at least one NUL
+            if (size + padded <= bytes.size()) {
+                std::memcpy(bytes.data() + size, text.data(), text.size());
+                size += padded;
+            }
+        }
+
+        void int32(int32_t value) {
+            uint32_t raw = static_cast<uint32_t>(value);
+            if constexpr (std::endian::native == std::endian::little) {
+                raw = __builtin_bswap32(raw);
+            }
+            if (size + 4 <= bytes.size()) {
+                std::memcpy(bytes.data() + size, &raw, 4);
+                size += 4;
+            }
+        }
+
+        void float32(float value) { int32(std::bit_cast<int32_t>(value)); }
+
+        const char* data() const { return bytes.data(); }
+        size_t length() const { return size; }
+    };
+
+public:
+    // target is host:port, e.g. 192.168.1.255:9000 or display.local:9000
+    static Result<OscSender> open(std::string_view destination) {
+        const size_t colon = destination.rfind(':');
+        if (colon == std::string_view::npos || colon == 0 || colon + 1 == destination.size()) {
+            return std::unexpected(TunerError(std::format("OSC target must be host:port, got {}", destination)));
+        }
+        const std::string host(destination.substr(0, colon));
+        const std::string port(destination.substr(colon + 1));
+
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* found = nullptr;
+        if (int error = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &found); error != 0) {
+            return std::unexpected(TunerError(std::format("Cannot resolve {}: {}", destination, ::gai_strerror(error))));
+        }
+
+        const int fd = ::socket(found->ai_family, found->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, found->ai_protocol);
+        if (fd < 0) {
+            const int error = errno;
+            ::freeaddrinfo(found);
+            return std::unexpected(TunerError(std::format("Cannot create a UDP socket: {}", std::strerror(error))));
+        }
+        const int enable = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+
+        OscSender sender(fd, found->ai_addr, found->ai_addrlen);
+        ::freeaddrinfo(found);
+        return sender;
+    }
+
+    OscSender(OscSender&& other) noexcept
+        : fd(std::exchange(other.fd, -1)), target(other.target), target_length(other.target_length) {}
+
+    OscSender& operator=(OscSender&& other) noexcept {
+        std::swap(fd, other.fd);
+        std::swap(target, other.target);
+        std::swap(target_length, other.target_length);
+        return *this;
+    }
+
+    ~OscSender() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    // Best effort: a full socket buffer or an unreachable display drops the message
+    bool send_reading(size_t row, std::string_view note, double frequency, double cents, double confidence) {
+        Packet packet;
+        packet.string("/tuner/reading");
+        packet.string(",isfff");
+        packet.int32(static_cast<int32_t>(row + 1));
+        packet.string(note);
+        packet.float32(static_cast<float>(frequency));
+        packet.float32(static_cast<float>(cents));
+        packet.float32(static_cast<float>(confidence));
+        return ::sendto(fd, packet.data(), packet.length(), MSG_DONTWAIT,
+                        reinterpret_cast<const sockaddr*>(&target), target_length) >= 0;
+    }
+};
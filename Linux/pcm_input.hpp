@@ -0,0 +1,287 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tuner_error.hpp"
+
+// Recorded input for offline analysis: WAV or headerless PCM, either memory-mapped
+// from a file or streamed from stdin in chunks.
+enum class PcmEncoding { s16, s24, s32, f32 };
+
+inline Result<PcmEncoding> parse_pcm_encoding(std::string_view name) {
+    if (name == "s16") return PcmEncoding::s16;
+    if (name == "s24") return PcmEncoding::s24;
+    if (name == "s32") return PcmEncoding::s32;
+    if (name == "f32") return PcmEncoding::f32;
+    return std::unexpected(TunerError(std::format("Unknown PCM sample format: {}", name)));
+}
+
+struct PcmFormat {
+    PcmEncoding encoding = PcmEncoding::f32;
+    size_t channels = 1;
+    double sample_rate = 44100.0;
+
+    constexpr size_t sample_bytes() const {
+        switch (encoding) {
+            case PcmEncoding::s16: return 2;
+            case PcmEncoding::s24: return 3;
+            case PcmEncoding::s32: case PcmEncoding::f32: break;
+        }
+        return 4;
+    }
+
+    constexpr size_t frame_bytes() const { return sample_bytes() * channels; }
+};
+
+namespace pcm_detail {
+
+// WAV is little-endian regardless of the host
+inline uint32_t read_le(const std::byte* p, size_t bytes) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint32_t>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+inline bool has_tag(std::span<const std::byte> bytes, std::string_view tag) {
+    return bytes.size() >= tag.size() && std::memcmp(bytes.data(), tag.data(), tag.size()) == 0;
+}
+
+} // namespace pcm_detail
+
+// Converts `frames` frames of one channel of interleaved PCM to float in [-1, 1)
+inline void decode_channel(const PcmFormat& format, const std::byte* data, size_t frames, size_t channel,
+                           std::span<float> out) {
+    using pcm_detail::read_le;
+
+    const size_t stride = format.frame_bytes();
+    const size_t bytes = format.sample_bytes();
+    const std::byte* p = data + channel * bytes;
+    const size_t count = std::min(frames, out.size());
+
+    for (size_t i = 0; i < count; ++i, p += stride) {
+        switch (format.encoding) {
+            case PcmEncoding::s16:
+                out[i] = static_cast<int16_t>(read_le(p, 2)) * (1.0f / 32768.0f);
+                break;
+            case PcmEncoding::s24:
+                // Sign-extend by placing the 24 bits at the top of an int32
+                out[i] = static_cast<int32_t>(read_le(p, 3) << 8) * (1.0f / 2147483648.0f);
+                break;
+            case PcmEncoding::s32:
+                out[i] = static_cast<int32_t>(read_le(p, 4)) * (1.0f / 2147483648.0f);
+                break;
+            case PcmEncoding::f32:
+                out[i] = std::bit_cast<float>(read_le(p, 4));
+                break;
+        }
+    }
+}
+
+// Parses the body of a WAV "fmt " chunk, including WAVE_FORMAT_EXTENSIBLE
+inline Result<PcmFormat> parse_fmt_chunk(std::span<const std::byte> body) {
+    using pcm_detail::read_le;
+
+    if (body.size() < 16) {
+        return std::unexpected(TunerError("Truncated WAV fmt chunk"));
+    }
+    uint32_t tag = read_le(body.data(), 2);
+    const uint32_t channels = read_le(body.data() + 2, 2);
+    const uint32_t rate = read_le(body.data() + 4, 4);
+    const uint32_t bits = read_le(body.data() + 14, 2);
+
+    // Extensible files carry the real format tag in the first bytes of the subformat GUID
+    if (tag == 0xFFFE && body.size() >= 26) {
+        tag = read_le(body.data() + 24, 2);
+    }
+
+    PcmFormat format;
+    if (tag == 1 && bits == 16) {
+        format.encoding = PcmEncoding::s16;
+    } else if (tag == 1 && bits == 24) {
+        format.encoding = PcmEncoding::s24;
+    } else if (tag == 1 && bits == 32) {
+        format.encoding = PcmEncoding::s32;
+    } else if (tag == 3 && bits == 32) {
+        format.encoding = PcmEncoding::f32;
+    } else {
+        return std::unexpected(TunerError(std::format("Unsupported WAV encoding (format {}, {} bits)", tag, bits)));
+    }
+    if (channels == 0 || rate == 0) {
+        return std::unexpected(TunerError("WAV file has no channels or no sample rate"));
+    }
+    format.channels = channels;
+    format.sample_rate = rate;
+    return format;
+}
+
+// Samples of a whole recording that is already in memory
+struct PcmView {
+    PcmFormat format;
+    std::span<const std::byte> data;
+
+    size_t frames() const { return data.size() / format.frame_bytes(); }
+};
+
+inline Result<PcmView> parse_wav(std::span<const std::byte> bytes) {
+    using pcm_detail::has_tag;
+    using pcm_detail::read_le;
+
+    if (bytes.size() < 12 || !has_tag(bytes, "RIFF") || !has_tag(bytes.subspan(8), "WAVE")) {
+        return std::unexpected(TunerError("Not a RIFF/WAVE file"));
+    }
+
+    Result<PcmFormat> format = std::unexpected(TunerError("WAV file has no fmt chunk"));
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        const auto header = bytes.subspan(pos, 8);
+        const size_t size = read_le(header.data() + 4, 4);
+        const auto body = bytes.subspan(pos + 8, std::min(size, bytes.size() - pos - 8));
+
+        if (has_tag(header, "fmt ")) {
+            format = parse_fmt_chunk(body);
+        } else if (has_tag(header, "data")) {
+            if (!format) {
+                return std::unexpected(format.error());
+            }
+            // Recorders that were interrupted leave a bogus size, so trust the file length
+            return PcmView{*format, body};
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return std::unexpected(TunerError("WAV file has no data chunk"));
+}
+
+// Read-only memory mapping of a whole file, so recordings are decoded straight from the page cache
+class MappedFile {
+    const std::byte* data = nullptr;
+    size_t length = 0;
+
+    MappedFile(const std::byte* mapped, size_t size) : data(mapped), length(size) {}
+
+public:
+    static Result<MappedFile> open(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return std::unexpected(TunerError(std::format("Cannot open {}: {}", path, std::strerror(errno))));
+        }
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return std::unexpected(TunerError(std::format("Cannot read {}", path)));
+        }
+
+        const size_t size = static_cast<size_t>(info.st_size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const int error = errno;
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return std::unexpected(TunerError(std::format("Cannot map {}: {}", path, std::strerror(error))));
+        }
+        ::madvise(mapped, size, MADV_SEQUENTIAL);
+        return MappedFile(static_cast<const std::byte*>(mapped), size);
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+        : data(std::exchange(other.data, nullptr)), length(std::exchange(other.length, 0)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        std::swap(data, other.data);
+        std::swap(length, other.length);
+        return *this;
+    }
+
+    ~MappedFile() {
+        if (data) {
+            ::munmap(const_cast<std::byte*>(data), length);
+        }
+    }
+
+    std::span<const std::byte> bytes() const { return std::span(data, length); }
+};
+
+// PCM arriving on a pipe, read in fixed-size chunks. A WAV header is parsed from the
+// stream unless a raw format is given.
+class PcmStream {
+    std::FILE* file;
+    PcmFormat stream_format;
+    std::vector<std::byte> chunk;
+    size_t filled = 0;  // bytes in chunk after the previous read
+    size_t carry = 0;   // trailing bytes of an incomplete frame from the previous read
+
+    PcmStream(std::FILE* input, const PcmFormat& format, size_t chunk_frames)
+        : file(input), stream_format(format), chunk(chunk_frames * format.frame_bytes()) {}
+
+    static bool read_exact(std::FILE* input, std::span<std::byte> out) {
+        return std::fread(out.data(), 1, out.size(), input) == out.size();
+    }
+
+    static Result<PcmFormat> read_wav_header(std::FILE* input) {
+        using pcm_detail::has_tag;
+        using pcm_detail::read_le;
+
+        std::array<std::byte, 12> riff{};
+        if (!read_exact(input, riff) || !has_tag(riff, "RIFF") || !has_tag(std::span(riff).subspan(8), "WAVE")) {
+            return std::unexpected(TunerError("Input stream is not a RIFF/WAVE file"));
+        }
+
+        Result<PcmFormat> format = std::unexpected(TunerError("WAV stream has no fmt chunk"));
+        std::array<std::byte, 8> header{};
+        std::vector<std::byte> body;
+        while (read_exact(input, header)) {
+            const size_t size = read_le(header.data() + 4, 4);
+            if (has_tag(header, "data")) {
+                return format;
+            }
+            body.resize(size + (size & 1));
+            if (!read_exact(input, body)) {
+                break;
+            }
+            if (has_tag(header, "fmt ")) {
+                format = parse_fmt_chunk(std::span(body).first(size));
+            }
+        }
+        return std::unexpected(TunerError("WAV stream has no data chunk"));
+    }
+
+public:
+    static Result<PcmStream> open(std::FILE* input, const std::optional<PcmFormat>& raw, size_t chunk_frames) {
+        if (raw) {
+            return PcmStream(input, *raw, chunk_frames);
+        }
+        auto format = read_wav_header(input);
+        if (!format) {
+            return std::unexpected(format.error());
+        }
+        return PcmStream(input, *format, chunk_frames);
+    }
+
+    const PcmFormat& format() const { return stream_format; }
+
+    // Next chunk of whole frames; empty at the end of the stream
+    std::span<const std::byte> read() {
+        const size_t frame = stream_format.frame_bytes();
+        std::memmove(chunk.data(), chunk.data() + filled - carry, carry);
+        filled = carry + std::fread(chunk.data() + carry, 1, chunk.size() - carry, file);
+        const size_t whole = filled / frame * frame;
+        carry = filled - whole;
+        return std::span<const std::byte>(chunk.data(), whole);
+    }
+};
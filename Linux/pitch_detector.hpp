@@ -0,0 +1,22 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+#include "tuner_error.hpp"
+
+// Common interface for the pitch estimators, so the analysis loop can swap
+// FFT peak picking for a time-domain detector without other changes.
+// Real selects the sample precision (float or double) of the whole pipeline.
+template<typename Real = double>
+class PitchDetector {
+public:
+    virtual ~PitchDetector() = default;
+    
+    virtual std::string_view name() const = 0;
+    
+    // Number of samples analyze() expects
+    virtual size_t size() const = 0;
+    
+    // Fundamental frequency of the frame in Hz
+    virtual Result<double> analyze(std::span<const Real> audio_data) = 0;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <format>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include "fft_analyzer.hpp"
+#include "mpm_detector.hpp"
+#include "yin_detector.hpp"
+
+// Selectable pitch detectors for the analysis loop
+enum class DetectorKind { fft, yin, mpm };
+
+inline Result<DetectorKind> parse_detector_kind(std::string_view name) {
+    if (name == "fft") return DetectorKind::fft;
+    if (name == "yin") return DetectorKind::yin;
+    if (name == "mpm") return DetectorKind::mpm;
+    return std::unexpected(TunerError(std::format("Unknown pitch detector: {}", name)));
+}
+
+template<typename Real = double>
+std::unique_ptr<PitchDetector<Real>> make_pitch_detector(DetectorKind kind, size_t window_size, double sample_rate,
+                                                         WindowType window = WindowType::hann,
+                                                         const SpectralPeakOptions& peak = {},
+                                                         std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    switch (kind) {
+        case DetectorKind::yin: return std::make_unique<YinDetector<Real>>(window_size, sample_rate, 0.12, 60.0, 1500.0, memory);
+        case DetectorKind::mpm: return std::make_unique<MpmDetector<Real>>(window_size, sample_rate, 0.93, 60.0, 1500.0, memory);
+        case DetectorKind::fft: break;
+    }
+    return std::make_unique<FFTAnalyzer<Real>>(window_size, sample_rate, window, peak, memory);
+}
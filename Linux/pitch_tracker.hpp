@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+// Per-stream smoothing of the per-window estimates, with constant state and work
+// per update. Estimates are tracked in cents (log frequency), where the jitter of
+// a detector is about the same on every string:
+//   1. an octave error (a strong 2nd partial, or a subharmonic) is folded back onto
+//      the tracked octave, unless it persists and so is a real octave change,
+//   2. a median of the last MEDIAN estimates removes single-window outliers,
+//   3. a scalar Kalman filter averages the medians, trusting them less the more
+//      they spread, and restarts when the note changes.
+// The spread also gives the confidence score, and tells the analysis whether a
+// longer window (stable note, precision wanted) or a shorter one (pitch moving,
+// speed wanted) would serve better.
+enum class WindowHint { shorten, keep, lengthen };
+
+class PitchTracker {
+    static constexpr size_t MEDIAN = 5;
+    static constexpr double OCTAVE_TOLERANCE = 40.0;    // cents around an exact octave jump
+    static constexpr size_t OCTAVE_HOLD = 4;            // folded estimates in a row before believing them
+    static constexpr double NEW_NOTE_CENTS = 80.0;      // farther than this from the track: another note
+    static constexpr size_t NEW_NOTE_HOLD = 2;
+    static constexpr double PROCESS_CENTS = 1.5;        // drift of a held note per update
+    static constexpr double MIN_SPREAD_CENTS = 0.5;
+    static constexpr double CONFIDENT_SPREAD = 8.0;     // spread at which confidence falls to 1 / e
+    static constexpr double STILL_CENTS = 1.0;          // median movement per update of a held note
+    static constexpr double MOVING_CENTS = 5.0;         // and of a note being bent or tuned
+    static constexpr size_t STABLE_UPDATES = 8;
+
+    std::array<double, MEDIAN> recent{};    // ring of folded estimates, in cents
+    size_t count = 0;
+    size_t next = 0;
+    double state = 0.0;             // smoothed pitch, cents above 1 Hz
+    double variance = 0.0;
+    double spread = 0.0;            // mean absolute deviation of the ring from its median
+    size_t octave_run = 0;
+    size_t new_note_run = 0;
+    size_t stable_run = 0;
+    double last_median = 0.0;
+    double velocity = 0.0;          // smoothed median movement, cents per update
+
+    static double to_cents(double frequency) { return 1200.0 * std::log2(frequency); }
+    static double to_hz(double cents) { return std::exp2(cents / 1200.0); }
+
+    void restart(double cents) {
+        count = 0;
+        next = 0;
+        octave_run = 0;
+        new_note_run = 0;
+        stable_run = 0;
+        push(cents);
+        state = cents;
+        last_median = cents;
+        velocity = 0.0;
+        variance = CONFIDENT_SPREAD * CONFIDENT_SPREAD;
+        spread = CONFIDENT_SPREAD;
+    }
+
+    void push(double cents) {
+        recent[next] = cents;
+        next = (next + 1) % MEDIAN;
+        count = std::min(count + 1, MEDIAN);
+    }
+
+    double median() const {
+        std::array<double, MEDIAN> sorted = recent;
+        std::sort(sorted.begin(), sorted.begin() + count);
+        return sorted[count / 2];
+    }
+
+public:
+    struct Estimate {
+        double frequency = 0.0;
+        double confidence = 0.0;    // 0 to 1
+    };
+
+    // Forgets the note, e.g. at a new onset
+    void reset() { count = 0; }
+
+    Estimate update(double frequency) {
+        if (!(frequency > 0.0)) {
+            return {state > 0.0 && count ? to_hz(state) : 0.0, 0.0};
+        }
+        double cents = to_cents(frequency);
+        if (count == 0) {
+            restart(cents);
+            return {frequency, confidence()};
+        }
+
+        // An estimate one octave off the track is an octave error until it persists
+        const double offset = cents - state;
+        const double octaves = std::round(offset / 1200.0);
+        if (octaves != 0.0 && std::abs(offset - octaves * 1200.0) < OCTAVE_TOLERANCE) {
+            if (++octave_run < OCTAVE_HOLD) {
+                cents -= octaves * 1200.0;
+            } else {
+                restart(cents);
+                return {frequency, confidence()};
+            }
+        } else {
+            octave_run = 0;
+        }
+
+        // Far from the track, and not for the first time: the string changed
+        if (std::abs(cents - state) > NEW_NOTE_CENTS) {
+            if (++new_note_run >= NEW_NOTE_HOLD) {
+                restart(cents);
+                return {frequency, confidence()};
+            }
+            return {to_hz(state), confidence()};
+        }
+        new_note_run = 0;
+
+        push(cents);
+        const double m = median();
+        double deviation = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            deviation += std::abs(recent[i] - m);
+        }
+        spread = std::max(deviation / static_cast<double>(count), MIN_SPREAD_CENTS);
+
+        // Predict with the drift of a held note plus the recent movement of the
+        // median (a peg being turned), correct with the median, whose noise is the
+        // ring's spread
+        variance += PROCESS_CENTS * PROCESS_CENTS + velocity * velocity;
+        const double noise = spread * spread;
+        const double gain = variance / (variance + noise);
+        state += gain * (m - state);
+        variance *= 1.0 - gain;
+
+        velocity = 0.5 * velocity + 0.5 * (m - last_median);
+        last_median = m;
+        stable_run = std::abs(velocity) < STILL_CENTS ? stable_run + 1 : 0;
+        return {to_hz(state), confidence()};
+    }
+
+    // Low spread over a full ring is high confidence
+    double confidence() const {
+        if (count == 0) {
+            return 0.0;
+        }
+        const double fill = static_cast<double>(count) / MEDIAN;
+        return fill * std::exp(-spread / CONFIDENT_SPREAD);
+    }
+
+    // A note that has held still for a while can afford a longer window; one whose
+    // median keeps moving needs a shorter one to follow it
+    WindowHint window_hint() const {
+        if (count < MEDIAN) {
+            return WindowHint::keep;
+        }
+        if (stable_run >= STABLE_UPDATES) {
+            return WindowHint::lengthen;
+        }
+        return std::abs(velocity) > MOVING_CENTS ? WindowHint::shorten : WindowHint::keep;
+    }
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Opt-in real-time operation for the audio path, shared by tuner.cpp and extend.cpp:
+// SCHED_FIFO for the audio callback and the analysis threads, optional CPU pinning,
+// and every page the stream touches locked and faulted in before it starts, so the
+// first seconds see no page faults. Each call returns 0 or an errno value; a
+// missing privilege (RLIMIT_RTPRIO, RLIMIT_MEMLOCK or CAP_SYS_NICE) is reported,
+// not fatal, and the tuner then runs with default scheduling.
+namespace realtime {
+
+struct Options {
+    bool enabled = false;
+    int priority = 70;              // analysis threads; the audio callback runs one above
+    std::vector<int> audio_cpus;    // empty = any CPU
+    std::vector<int> analysis_cpus; // worker w runs on analysis_cpus[w % size]
+};
+
+// Deep enough for the analysis call chain, including the detectors' stack arrays
+inline constexpr size_t STACK_PREFAULT_BYTES = 256 * 1024;
+
+// CPU list such as "2,3" or "4-7"; empty if the list is invalid
+inline std::vector<int> parse_cpus(std::string_view list)
+{
+    std::vector<int> cpus;
+    while (!list.empty()) {
+        const std::string_view item = list.substr(0, list.find(','));
+        list.remove_prefix(std::min(item.size() + 1, list.size()));
+
+        int first = 0;
+        int last = 0;
+        const char* end = item.data() + item.size();
+        auto parsed = std::from_chars(item.data(), end, first);
+        last = first;
+        if (parsed.ec == std::errc{} && parsed.ptr != end && *parsed.ptr == '-') {
+            parsed = std::from_chars(parsed.ptr + 1, end, last);
+        }
+        if (parsed.ec != std::errc{} || parsed.ptr != end || first < 0 || last < first || last >= CPU_SETSIZE) {
+            return {};
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Restricts the calling thread to the given CPUs; an empty list leaves it unpinned
+inline int pin_current_thread(std::span<const int> cpus)
+{
+    if (cpus.empty()) {
+        return 0;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// SCHED_FIFO for the calling thread, unless it already runs real-time at least as
+// high (a JACK callback thread, for one)
+inline int set_fifo_priority(int priority)
+{
+    int policy = SCHED_OTHER;
+    sched_param param{};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0
+        && (policy == SCHED_FIFO || policy == SCHED_RR) && param.sched_priority >= priority) {
+        return 0;
+    }
+    param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+}
+
+// Grows the calling thread's stack to STACK_PREFAULT_BYTES now rather than under load
+[[gnu::noinline]] inline void prefault_stack()
+{
+    volatile unsigned char stack[STACK_PREFAULT_BYTES];
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (size_t offset = 0; offset < sizeof(stack); offset += page) {
+        stack[offset] = 0;
+    }
+}
+
+// Locks all current and future pages in RAM, which also faults in every buffer and
+// plan allocated so far. malloc is told to keep freed memory rather than return it,
+// so a later allocation reuses locked, resident pages instead of mapping new ones.
+inline int lock_memory()
+{
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0 ? 0 : errno;
+}
+
+// The audio callback's thread, from its first call: one above the analysis
+inline int promote_audio_thread(const Options& options)
+{
+    const int pinned = pin_current_thread(options.audio_cpus);
+    const int scheduled = set_fifo_priority(options.priority + 1);
+    return scheduled ? scheduled : pinned;
+}
+
+// An analysis worker, before its first frame
+inline int promote_analysis_thread(const Options& options, size_t worker)
+{
+    int pinned = 0;
+    if (!options.analysis_cpus.empty()) {
+        const int cpu = options.analysis_cpus[worker % options.analysis_cpus.size()];
+        pinned = pin_current_thread(std::span(&cpu, 1));
+    }
+    const int scheduled = set_fifo_priority(options.priority);
+    prefault_stack();
+    return scheduled ? scheduled : pinned;
+}
+
+} // namespace realtime
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <utility>
+
+// Runs a callable when the enclosing scope is left, by return or by exception; the
+// std::scope_exit of the Library Fundamentals TS, which the standard libraries do
+// not ship
+template<typename F>
+class ScopeExit {
+    F on_exit;
+
+public:
+    explicit ScopeExit(F f) : on_exit(std::move(f)) {}
+
+    ScopeExit(const ScopeExit&) = delete;
+    ScopeExit& operator=(const ScopeExit&) = delete;
+
+    ~ScopeExit() { on_exit(); }
+};
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "snapshot.hpp"
+#include "tuner_error.hpp"
+
+// Latest results in a POSIX shared-memory segment, one seqlock cell per row (a
+// channel, or a string in strum mode). The analysis writes each result straight into
+// its row; any number of local processes map the segment read-only and poll it with
+// plain loads, so reading costs no syscall and never delays the writer.
+struct SharedReading {
+    double frequency = 0.0;     // smoothed estimate; 0 until something is detected
+    double target_hz = 0.0;     // the matched note or open string
+    double cents = 0.0;
+    double confidence = 0.0;    // 0 to 1
+    int32_t note_index = -1;    // 0 = C ... 11 = B, -1 if none
+    int32_t octave = 0;
+    uint64_t time_ns = 0;       // CLOCK_MONOTONIC at publish, comparable across processes
+};
+
+enum class SharedLayout : uint32_t { channels, strings };
+
+struct SharedSegment {
+    static constexpr uint32_t MAGIC = 0x4754554E;   // "GTUN"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t MAX_ROWS = 16;
+
+    std::atomic<uint32_t> magic{0};     // set last, once the header is complete
+    uint32_t version = VERSION;
+    uint32_t rows = 0;
+    SharedLayout layout = SharedLayout::channels;
+    double sample_rate = 0.0;           // device rate
+    double a4_hz = 0.0;
+    std::atomic<uint64_t> heartbeat_ns{0};  // refreshed by the writer; a stale value means it died
+    std::array<Snapshot<SharedReading>, MAX_ROWS> readings;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared-memory seqlocks need address-free atomics");
+
+namespace shared_detail {
+
+// shm_open wants a single leading slash
+inline std::string segment_path(std::string_view name) {
+    return name.starts_with('/') ? std::string(name) : std::format("/{}", name);
+}
+
+} // namespace shared_detail
+
+// Writer side: creates the segment and removes its name again on destruction.
+// The writer holds an exclusive flock on the segment for its lifetime, so a second
+// writer under the same name is refused rather than taking the rows over; the kernel
+// drops the lock when a writer dies, which leaves its segment free to reclaim.
+class SharedResults {
+    SharedSegment* segment = nullptr;
+    int fd = -1;
+    std::string path;
+
+    SharedResults(SharedSegment* mapped, int locked_fd, std::string name)
+        : segment(mapped), fd(locked_fd), path(std::move(name)) {}
+
+public:
+    static Result<SharedResults> create(std::string_view name, SharedLayout layout, size_t rows,
+                                        double sample_rate, double a4_hz) {
+        std::string path = shared_detail::segment_path(name);
+        if (rows == 0 || rows > SharedSegment::MAX_ROWS) {
+            return std::unexpected(TunerError(std::format("Shared segment {} cannot hold {} rows", path, rows)));
+        }
+        const int fd = ::shm_open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return std::unexpected(TunerError(std::format("Cannot create {}: {}", path, std::strerror(errno))));
+        }
+        if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            const int error = errno;
+            ::close(fd);
+            if (error == EWOULDBLOCK) {
+                return std::unexpected(TunerError(std::format("{} is already published by another daemon", path)));
+            }
+            return std::unexpected(TunerError(std::format("Cannot lock {}: {}", path, std::strerror(error))));
+        }
+        // A stale segment left by a writer that was killed is reinitialized in place, so
+        // readers still mapping it see the new writer rather than a truncated file
+        if (::ftruncate(fd, sizeof(SharedSegment)) != 0) {
+            const int error = errno;
+            ::close(fd);
+            return std::unexpected(TunerError(std::format("Cannot size {}: {}", path, std::strerror(error))));
+        }
+        void* mapped = ::mmap(nullptr, sizeof(SharedSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            const int error = errno;
+            ::close(fd);
+            return std::unexpected(TunerError(std::format("Cannot map {}: {}", path, std::strerror(error))));
+        }
+
+        auto* segment = new (mapped) SharedSegment{};
+        segment->rows = static_cast<uint32_t>(rows);
+        segment->layout = layout;
+        segment->sample_rate = sample_rate;
+        segment->a4_hz = a4_hz;
+        segment->magic.store(SharedSegment::MAGIC, std::memory_order_release);
+        return SharedResults(segment, fd, std::move(path));
+    }
+
+    SharedResults(SharedResults&& other) noexcept
+        : segment(std::exchange(other.segment, nullptr)), fd(std::exchange(other.fd, -1)), path(std::move(other.path)) {}
+
+    SharedResults& operator=(SharedResults&& other) noexcept {
+        std::swap(segment, other.segment);
+        std::swap(fd, other.fd);
+        std::swap(path, other.path);
+        return *this;
+    }
+
+    // The name is removed while the lock is still held, so a writer starting now
+    // creates a fresh segment instead of reusing this one
+    ~SharedResults() {
+        if (segment) {
+            segment->magic.store(0, std::memory_order_release);
+            ::munmap(segment, sizeof(SharedSegment));
+            ::shm_unlink(path.c_str());
+            ::close(fd);
+        }
+    }
+
+    const std::string& name() const { return path; }
+
+    // Lock-free and wait-free; safe from any single writer per row
+    void publish(size_t row, const SharedReading& reading) noexcept {
+        segment->readings[row].publish(reading);
+    }
+
+    void heartbeat(uint64_t now_ns) noexcept {
+        segment->heartbeat_ns.store(now_ns, std::memory_order_relaxed);
+    }
+};
+
+// Reader side: a read-only mapping of a running writer's segment
+class SharedResultsView {
+    const SharedSegment* segment = nullptr;
+
+    explicit SharedResultsView(const SharedSegment* mapped) : segment(mapped) {}
+
+public:
+    static Result<SharedResultsView> open(std::string_view name) {
+        const std::string path = shared_detail::segment_path(name);
+        const int fd = ::shm_open(path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) {
+            return std::unexpected(TunerError(std::format("Cannot open {}: {}", path, std::strerror(errno))));
+        }
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SharedSegment)) {
+            ::close(fd);
+            return std::unexpected(TunerError(std::format("{} is not a tuner segment", path)));
+        }
+        void* mapped = ::mmap(nullptr, sizeof(SharedSegment), PROT_READ, MAP_SHARED, fd, 0);
+        const int error = errno;
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return std::unexpected(TunerError(std::format("Cannot map {}: {}", path, std::strerror(error))));
+        }
+
+        const auto* segment = static_cast<const SharedSegment*>(mapped);
+        if (segment->magic.load(std::memory_order_acquire) != SharedSegment::MAGIC
+            || segment->version != SharedSegment::VERSION) {
+            ::munmap(mapped, sizeof(SharedSegment));
+            return std::unexpected(TunerError(std::format("{} has no tuner running behind it", path)));
+        }
+        return SharedResultsView(segment);
+    }
+
+    SharedResultsView(SharedResultsView&& other) noexcept : segment(std::exchange(other.segment, nullptr)) {}
+
+    SharedResultsView& operator=(SharedResultsView&& other) noexcept {
+        std::swap(segment, other.segment);
+        return *this;
+    }
+
+    ~SharedResultsView() {
+        if (segment) {
+            ::munmap(const_cast<SharedSegment*>(segment), sizeof(SharedSegment));
+        }
+    }
+
+    // False once the writer has shut down
+    bool live() const noexcept { return segment->magic.load(std::memory_order_acquire) == SharedSegment::MAGIC; }
+
+    size_t rows() const noexcept { return segment->rows; }
+    SharedLayout layout() const noexcept { return segment->layout; }
+    double sample_rate() const noexcept { return segment->sample_rate; }
+    double a4_hz() const noexcept { return segment->a4_hz; }
+    uint64_t heartbeat_ns() const noexcept { return segment->heartbeat_ns.load(std::memory_order_relaxed); }
+
+    uint64_t version(size_t row) const noexcept { return segment->readings[row].version(); }
+    SharedReading load(size_t row) const noexcept { return segment->readings[row].load(); }
+};
@@ -0,0 +1,457 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TUNER_SIMD_X86 1
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TUNER_SIMD_NEON 1
+#endif
+
+// Vectorized hot-loop kernels with runtime dispatch.
+// x86 picks AVX2+FMA when the CPU supports it; AArch64 always has NEON.
+// GUITAR_TUNER_SIMD=scalar forces the portable fallback, e.g. for comparisons.
+namespace simd {
+
+// Largest |X[k]|^2 in a bin range of an interleaved (re, im) spectrum
+struct Peak {
+    size_t index = 0;
+    double power = 0.0;
+};
+
+namespace scalar {
+
+inline void convert(const float* in, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<double>(in[i]);
+    }
+}
+
+inline void multiply(const double* a, const double* b, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+inline void convert_window(const float* in, const double* window, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<double>(in[i]) * window[i];
+    }
+}
+
+inline void multiply(const float* a, const float* b, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+template<typename Real>
+Peak peak_power(const Real* spectrum, size_t begin, size_t end) {
+    Peak peak{begin, -1.0};
+    for (size_t k = begin; k < end; ++k) {
+        const Real re = spectrum[2 * k];
+        const Real im = spectrum[2 * k + 1];
+        const double power = re * re + im * im;
+        if (power > peak.power) {
+            peak = {k, power};
+        }
+    }
+    return peak;
+}
+
+inline double sum_squares(const float* in, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += static_cast<double>(in[i]) * in[i];
+    }
+    return sum;
+}
+
+inline float dot(const float* a, const float* b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+} // namespace scalar
+
+#if TUNER_SIMD_X86
+namespace avx2 {
+
+__attribute__((target("avx2,fma")))
+inline void convert(const float* in, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm_loadu_ps(in + i)));
+        _mm256_storeu_pd(out + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(in + i + 4)));
+    }
+    scalar::convert(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+inline void multiply(const double* a, const double* b, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    scalar::multiply(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+inline void convert_window(const float* in, const double* window, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(in + i)), _mm256_loadu_pd(window + i)));
+    }
+    scalar::convert_window(in + i, window + i, out + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+inline Peak peak_power(const double* spectrum, size_t begin, size_t end) {
+    if (end - begin < 8) {
+        return scalar::peak_power(spectrum, begin, end);
+    }
+
+    // hadd of two (re, im, re, im) vectors yields the powers of bins k, k+2, k+1, k+3
+    const __m256d lane_offsets = _mm256_set_pd(3.0, 1.0, 2.0, 0.0);
+    __m256d best_power = _mm256_set1_pd(-1.0);
+    __m256d best_index = _mm256_setzero_pd();
+
+    size_t k = begin;
+    for (; k + 4 <= end; k += 4) {
+        const __m256d lo = _mm256_loadu_pd(spectrum + 2 * k);
+        const __m256d hi = _mm256_loadu_pd(spectrum + 2 * k + 4);
+        const __m256d power = _mm256_hadd_pd(_mm256_mul_pd(lo, lo), _mm256_mul_pd(hi, hi));
+        const __m256d index = _mm256_add_pd(_mm256_set1_pd(static_cast<double>(k)), lane_offsets);
+        const __m256d greater = _mm256_cmp_pd(power, best_power, _CMP_GT_OQ);
+        best_power = _mm256_blendv_pd(best_power, power, greater);
+        best_index = _mm256_blendv_pd(best_index, index, greater);
+    }
+
+    alignas(32) double powers[4];
+    alignas(32) double indices[4];
+    _mm256_store_pd(powers, best_power);
+    _mm256_store_pd(indices, best_index);
+
+    // Ties go to the lowest bin, matching the scalar first-maximum rule
+    Peak peak = scalar::peak_power(spectrum, k, end);
+    for (int lane = 0; lane < 4; ++lane) {
+        const size_t index = static_cast<size_t>(indices[lane]);
+        if (powers[lane] > peak.power || (powers[lane] == peak.power && index < peak.index)) {
+            peak = {index, powers[lane]};
+        }
+    }
+    return peak;
+}
+
+__attribute__((target("avx2,fma")))
+inline void multiply(const float* a, const float* b, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    scalar::multiply(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+inline Peak peak_power(const float* spectrum, size_t begin, size_t end) {
+    if (end - begin < 16) {
+        return scalar::peak_power(spectrum, begin, end);
+    }
+
+    // Per 128-bit lane, hadd of two (re, im, ...) vectors yields the powers of bins
+    // k, k+1, k+4, k+5 | k+2, k+3, k+6, k+7
+    const __m256i lane_offsets = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+    __m256 best_power = _mm256_set1_ps(-1.0f);
+    __m256i best_index = _mm256_setzero_si256();
+
+    size_t k = begin;
+    for (; k + 8 <= end; k += 8) {
+        const __m256 lo = _mm256_loadu_ps(spectrum + 2 * k);
+        const __m256 hi = _mm256_loadu_ps(spectrum + 2 * k + 8);
+        const __m256 power = _mm256_hadd_ps(_mm256_mul_ps(lo, lo), _mm256_mul_ps(hi, hi));
+        const __m256i index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(k)), lane_offsets);
+        const __m256 greater = _mm256_cmp_ps(power, best_power, _CMP_GT_OQ);
+        best_power = _mm256_blendv_ps(best_power, power, greater);
+        best_index = _mm256_castps_si256(_mm256_blendv_ps(
+            _mm256_castsi256_ps(best_index), _mm256_castsi256_ps(index), greater));
+    }
+
+    alignas(32) float powers[8];
+    alignas(32) int32_t indices[8];
+    _mm256_store_ps(powers, best_power);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indices), best_index);
+
+    Peak peak = scalar::peak_power(spectrum, k, end);
+    for (int lane = 0; lane < 8; ++lane) {
+        const size_t index = static_cast<size_t>(indices[lane]);
+        if (powers[lane] > peak.power || (powers[lane] == peak.power && index < peak.index)) {
+            peak = {index, powers[lane]};
+        }
+    }
+    return peak;
+}
+
+__attribute__((target("avx2,fma")))
+inline double sum_squares(const float* in, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256d a = _mm256_cvtps_pd(_mm_loadu_ps(in + i));
+        const __m256d b = _mm256_cvtps_pd(_mm_loadu_ps(in + i + 4));
+        acc0 = _mm256_fmadd_pd(a, a, acc0);
+        acc1 = _mm256_fmadd_pd(b, b, acc1);
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalar::sum_squares(in + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+inline float dot(const float* a, const float* b, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+    }
+    const __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    const __m128 pair = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1))) + scalar::dot(a + i, b + i, n - i);
+}
+
+} // namespace avx2
+#endif
+
+#if TUNER_SIMD_NEON
+namespace neon {
+
+inline void convert(const float* in, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t v = vld1q_f32(in + i);
+        vst1q_f64(out + i, vcvt_f64_f32(vget_low_f32(v)));
+        vst1q_f64(out + i + 2, vcvt_high_f64_f32(v));
+    }
+    scalar::convert(in + i, out + i, n - i);
+}
+
+inline void multiply(const double* a, const double* b, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(out + i, vmulq_f64(vld1q_f64(a + i), vld1q_f64(b + i)));
+    }
+    scalar::multiply(a + i, b + i, out + i, n - i);
+}
+
+inline void convert_window(const float* in, const double* window, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t v = vld1q_f32(in + i);
+        vst1q_f64(out + i, vmulq_f64(vcvt_f64_f32(vget_low_f32(v)), vld1q_f64(window + i)));
+        vst1q_f64(out + i + 2, vmulq_f64(vcvt_high_f64_f32(v), vld1q_f64(window + i + 2)));
+    }
+    scalar::convert_window(in + i, window + i, out + i, n - i);
+}
+
+inline Peak peak_power(const double* spectrum, size_t begin, size_t end) {
+    if (end - begin < 4) {
+        return scalar::peak_power(spectrum, begin, end);
+    }
+
+    // vld2q de-interleaves two bins into (re0, re1) and (im0, im1)
+    const float64x2_t lane_offsets = {0.0, 1.0};
+    float64x2_t best_power = vdupq_n_f64(-1.0);
+    float64x2_t best_index = vdupq_n_f64(0.0);
+
+    size_t k = begin;
+    for (; k + 2 <= end; k += 2) {
+        const float64x2x2_t bins = vld2q_f64(spectrum + 2 * k);
+        const float64x2_t power = vfmaq_f64(vmulq_f64(bins.val[0], bins.val[0]), bins.val[1], bins.val[1]);
+        const float64x2_t index = vaddq_f64(vdupq_n_f64(static_cast<double>(k)), lane_offsets);
+        const uint64x2_t greater = vcgtq_f64(power, best_power);
+        best_power = vbslq_f64(greater, power, best_power);
+        best_index = vbslq_f64(greater, index, best_index);
+    }
+
+    Peak peak = scalar::peak_power(spectrum, k, end);
+    for (int lane = 0; lane < 2; ++lane) {
+        const double power = lane == 0 ? vgetq_lane_f64(best_power, 0) : vgetq_lane_f64(best_power, 1);
+        const size_t index = static_cast<size_t>(lane == 0 ? vgetq_lane_f64(best_index, 0) : vgetq_lane_f64(best_index, 1));
+        if (power > peak.power || (power == peak.power && index < peak.index)) {
+            peak = {index, power};
+        }
+    }
+    return peak;
+}
+
+inline void multiply(const float* a, const float* b, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    }
+    scalar::multiply(a + i, b + i, out + i, n - i);
+}
+
+inline Peak peak_power(const float* spectrum, size_t begin, size_t end) {
+    if (end - begin < 8) {
+        return scalar::peak_power(spectrum, begin, end);
+    }
+
+    const uint32x4_t lane_offsets = {0, 1, 2, 3};
+    float32x4_t best_power = vdupq_n_f32(-1.0f);
+    uint32x4_t best_index = vdupq_n_u32(0);
+
+    size_t k = begin;
+    for (; k + 4 <= end; k += 4) {
+        const float32x4x2_t bins = vld2q_f32(spectrum + 2 * k);
+        const float32x4_t power = vfmaq_f32(vmulq_f32(bins.val[0], bins.val[0]), bins.val[1], bins.val[1]);
+        const uint32x4_t index = vaddq_u32(vdupq_n_u32(static_cast<uint32_t>(k)), lane_offsets);
+        const uint32x4_t greater = vcgtq_f32(power, best_power);
+        best_power = vbslq_f32(greater, power, best_power);
+        best_index = vbslq_u32(greater, index, best_index);
+    }
+
+    float powers[4];
+    uint32_t indices[4];
+    vst1q_f32(powers, best_power);
+    vst1q_u32(indices, best_index);
+
+    Peak peak = scalar::peak_power(spectrum, k, end);
+    for (int lane = 0; lane < 4; ++lane) {
+        if (powers[lane] > peak.power || (powers[lane] == peak.power && indices[lane] < peak.index)) {
+            peak = {indices[lane], powers[lane]};
+        }
+    }
+    return peak;
+}
+
+inline double sum_squares(const float* in, size_t n) {
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t v = vld1q_f32(in + i);
+        const float64x2_t lo = vcvt_f64_f32(vget_low_f32(v));
+        const float64x2_t hi = vcvt_high_f64_f32(v);
+        acc0 = vfmaq_f64(acc0, lo, lo);
+        acc1 = vfmaq_f64(acc1, hi, hi);
+    }
+    return vaddvq_f64(vaddq_f64(acc0, acc1)) + scalar::sum_squares(in + i, n - i);
+}
+
+inline float dot(const float* a, const float* b, size_t n) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vfmaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    return vaddvq_f32(acc) + scalar::dot(a + i, b + i, n - i);
+}
+
+} // namespace neon
+#endif
+
+struct Kernels {
+    std::string_view name;
+    void (*convert)(const float*, double*, size_t);
+    void (*multiply)(const double*, const double*, double*, size_t);
+    Peak (*peak_power)(const double*, size_t, size_t);
+    double (*sum_squares)(const float*, size_t);
+    void (*multiply_f32)(const float*, const float*, float*, size_t);
+    Peak (*peak_power_f32)(const float*, size_t, size_t);
+    void (*convert_window)(const float*, const double*, double*, size_t);
+    float (*dot_f32)(const float*, const float*, size_t);
+};
+
+inline Kernels select_kernels() {
+    const char* forced = std::getenv("GUITAR_TUNER_SIMD");
+    const bool force_scalar = forced && std::string_view(forced) == "scalar";
+
+#if TUNER_SIMD_X86
+    if (!force_scalar && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return {"avx2", avx2::convert, avx2::multiply, avx2::peak_power, avx2::sum_squares,
+                avx2::multiply, avx2::peak_power, avx2::convert_window, avx2::dot};
+    }
+#endif
+#if TUNER_SIMD_NEON
+    if (!force_scalar) {
+        return {"neon", neon::convert, neon::multiply, neon::peak_power, neon::sum_squares,
+                neon::multiply, neon::peak_power, neon::convert_window, neon::dot};
+    }
+#endif
+    (void)force_scalar;
+    return {"scalar", scalar::convert, scalar::multiply, scalar::peak_power<double>, scalar::sum_squares,
+            scalar::multiply, scalar::peak_power<float>, scalar::convert_window, scalar::dot};
+}
+
+// Selected once, on first use
+inline const Kernels& kernels() {
+    static const Kernels selected = select_kernels();
+    return selected;
+}
+
+inline std::string_view active_isa() {
+    return kernels().name;
+}
+
+// out[i] = in[i], widened to double
+inline void convert(std::span<const float> in, std::span<double> out) {
+    kernels().convert(in.data(), out.data(), std::min(in.size(), out.size()));
+}
+
+// Single-precision pipelines keep the samples as they are
+inline void convert(std::span<const float> in, std::span<float> out) {
+    std::copy_n(in.begin(), std::min(in.size(), out.size()), out.begin());
+}
+
+// out[i] = a[i] * b[i]; out may alias either input
+inline void multiply(std::span<const double> a, std::span<const double> b, std::span<double> out) {
+    kernels().multiply(a.data(), b.data(), out.data(), std::min({a.size(), b.size(), out.size()}));
+}
+
+inline void multiply(std::span<const float> a, std::span<const float> b, std::span<float> out) {
+    kernels().multiply_f32(a.data(), b.data(), out.data(), std::min({a.size(), b.size(), out.size()}));
+}
+
+// out[i] = in[i] * window[i]: windows the captured samples straight into an FFT
+// input buffer, widening to double in the same pass
+inline void apply_window(std::span<const float> in, std::span<const double> window, std::span<double> out) {
+    kernels().convert_window(in.data(), window.data(), out.data(), std::min({in.size(), window.size(), out.size()}));
+}
+
+inline void apply_window(std::span<const float> in, std::span<const float> window, std::span<float> out) {
+    multiply(in, window, out);
+}
+
+// Argmax of re^2 + im^2 over bins [begin, end) of an FFTW r2c output; no sqrt needed
+inline Peak peak_power(const double (*spectrum)[2], size_t begin, size_t end) {
+    return kernels().peak_power(&spectrum[0][0], begin, end);
+}
+
+inline Peak peak_power(const float (*spectrum)[2], size_t begin, size_t end) {
+    return kernels().peak_power_f32(&spectrum[0][0], begin, end);
+}
+
+// sum of a[i] * b[i]; the FIR inner product
+inline float dot(std::span<const float> a, std::span<const float> b) {
+    return kernels().dot_f32(a.data(), b.data(), std::min(a.size(), b.size()));
+}
+
+inline double rms(std::span<const float> in) {
+    return in.empty() ? 0.0 : std::sqrt(kernels().sum_squares(in.data(), in.size()) / in.size());
+}
+
+} // namespace simd
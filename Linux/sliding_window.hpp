@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include "arena.hpp"
+
+// Accumulates incoming samples and emits an analysis window every hop_size samples,
+// independent of how the device chunks its buffers.
+// Samples are written twice into a buffer of 2 * window_size, so the most recent
+// window is always contiguous and no per-hop copying is needed.
+template<typename T>
+class SlidingWindow {
+    size_t window_length;
+    size_t hop_length;
+    AlignedBuffer<T> buffer;
+    size_t write_pos = 0;       // index of the oldest sample in the current window
+    size_t filled = 0;          // samples received until the first window is complete
+    size_t since_emit = 0;      // samples received since the last emitted window
+
+public:
+    SlidingWindow(size_t window_size, size_t hop_size,
+                  std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : window_length(window_size),
+          hop_length(std::clamp<size_t>(hop_size, 1, window_size)),
+          buffer(2 * window_size, memory) {}
+
+    size_t window_size() const noexcept { return window_length; }
+    size_t hop_size() const noexcept { return hop_length; }
+
+    // The most recent window_size samples, oldest first
+    std::span<const T> window() const noexcept {
+        return std::span<const T>(buffer.get() + write_pos, window_length);
+    }
+
+    void reset() noexcept {
+        write_pos = 0;
+        filled = 0;
+        since_emit = 0;
+    }
+
+    // Feeds samples and calls on_window(window()) once for every completed hop
+    template<typename OnWindow>
+    void push(std::span<const T> samples, OnWindow&& on_window) {
+        for (const T sample : samples) {
+            buffer[write_pos] = sample;
+            buffer[write_pos + window_length] = sample;
+            write_pos = (write_pos + 1) % window_length;
+
+            if (filled < window_length) {
+                ++filled;
+                if (filled < window_length) {
+                    continue;
+                }
+            } else if (++since_emit < hop_length) {
+                continue;
+            }
+            since_emit = 0;
+            on_window(window());
+        }
+    }
+};
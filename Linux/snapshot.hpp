@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer, many-reader latest-value cell (a seqlock).
+// The writer never blocks; a reader retries only if it raced a write.
+// The payload is stored as relaxed atomic words so concurrent copies are race-free.
+template<typename T>
+    requires std::is_trivially_copyable_v<T>
+class Snapshot {
+    static constexpr size_t word_count = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    alignas(64) std::atomic<uint64_t> sequence{0};
+    std::array<std::atomic<uint64_t>, word_count> words{};
+
+public:
+    void publish(const T& value) noexcept {
+        std::array<uint64_t, word_count> raw{};
+        std::memcpy(raw.data(), &value, sizeof(T));
+
+        const uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);      // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < word_count; ++i) {
+            words[i].store(raw[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Number of completed publishes; lets readers skip work when nothing changed
+    uint64_t version() const noexcept {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+    T load() const noexcept {
+        std::array<uint64_t, word_count> raw{};
+        uint64_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < word_count; ++i) {
+                raw[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while (before != after || (before & 1));
+
+        T value;
+        std::memcpy(static_cast<void*>(&value), raw.data(), sizeof(T));
+        return value;
+    }
+};
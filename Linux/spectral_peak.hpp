@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <span>
+#include <string_view>
+#include "tuner_error.hpp"
+
+// Fundamental selection on an r2c spectrum:
+//   max - strongest bin; cheapest, but a strong 2nd or 3rd partial wins over a weak fundamental
+//   hps - Harmonic Product Spectrum; the bin whose harmonics are jointly strongest
+enum class PeakPicking { max, hps };
+
+inline Result<PeakPicking> parse_peak_picking(std::string_view name) {
+    if (name == "max") return PeakPicking::max;
+    if (name == "hps") return PeakPicking::hps;
+    return std::unexpected(TunerError(std::format("Unknown peak picking method: {}", name)));
+}
+
+struct SpectralPeakOptions {
+    PeakPicking picking = PeakPicking::max;
+    size_t harmonics = 5;       // spectra multiplied by HPS, including the fundamental
+    size_t zero_padding = 1;    // FFT length as a multiple of the window: 1, 2 or 4
+};
+
+namespace spectral {
+
+// Keeps log() finite on bins that are exactly zero
+inline constexpr double power_floor = 1e-30;
+
+// Natural log of |X[k]|^2 for every bin of an interleaved (re, im) spectrum
+template<typename Real>
+void log_power(const Real (*spectrum)[2], std::span<double> out) {
+    for (size_t k = 0; k < out.size(); ++k) {
+        const double re = spectrum[k][0];
+        const double im = spectrum[k][1];
+        out[k] = std::log(re * re + im * im + power_floor);
+    }
+}
+
+template<typename Real>
+double log_power_at(const Real (*spectrum)[2], size_t k) {
+    const double re = spectrum[k][0];
+    const double im = spectrum[k][1];
+    return std::log(re * re + im * im + power_floor);
+}
+
+// Fractional peak position from the log power of a bin and its two neighbours.
+// A parabola through log magnitude is exact for a Gaussian-shaped peak and within a
+// few hundredths of a bin for the Hann and Blackman-Harris main lobes. Returns the
+// bin itself when the three points do not describe a maximum.
+inline double interpolate_peak(double below, double at, double above, size_t bin) {
+    const double curvature = below - 2.0 * at + above;
+    if (!(curvature < 0.0)) {
+        return static_cast<double>(bin);
+    }
+    const double offset = 0.5 * (below - above) / curvature;
+    return bin + std::clamp(offset, -0.5, 0.5);
+}
+
+inline double interpolate_peak(std::span<const double> log_power, size_t bin) {
+    if (bin == 0 || bin + 1 >= log_power.size()) {
+        return static_cast<double>(bin);
+    }
+    return interpolate_peak(log_power[bin - 1], log_power[bin], log_power[bin + 1], bin);
+}
+
+template<typename Real>
+double interpolate_peak(const Real (*spectrum)[2], size_t bins, size_t bin) {
+    if (bin == 0 || bin + 1 >= bins) {
+        return static_cast<double>(bin);
+    }
+    return interpolate_peak(log_power_at(spectrum, bin - 1), log_power_at(spectrum, bin),
+                            log_power_at(spectrum, bin + 1), bin);
+}
+
+// Bin in [begin, log_power.size() / harmonics) maximizing sum_h log|X[h k]|^2, i.e.
+// the product of the spectrum and its downsampled copies. A single harmonic is the
+// plain maximum; the last bin is never a candidate, as it has no upper neighbour.
+// Where the partials above a candidate are all at the noise floor, a subharmonic of a
+// single strong peak scores as well as the peak itself, so candidates whose own bin
+// (or a neighbour) is below min_log_power are skipped. No bin is found when the range
+// holds no candidate at all.
+inline std::optional<size_t> harmonic_product_peak(std::span<const double> log_power, size_t harmonics,
+                                                   size_t begin, double min_log_power) {
+    harmonics = std::max<size_t>(harmonics, 1);
+    const size_t first = std::max<size_t>(begin, 1);
+    const size_t end = log_power.empty() ? 0 : std::min(log_power.size() / harmonics, log_power.size() - 1);
+    if (first >= end) {
+        return std::nullopt;
+    }
+    size_t best = first;
+    double best_score = -INFINITY;
+    for (size_t k = first; k < end; ++k) {
+        if (std::max({log_power[k - 1], log_power[k], log_power[k + 1]}) < min_log_power) {
+            continue;
+        }
+        double score = 0.0;
+        for (size_t h = 1; h <= harmonics; ++h) {
+            score += log_power[h * k];
+        }
+        if (score > best_score) {
+            best_score = score;
+            best = k;
+        }
+    }
+    return best;
+}
+
+// The HPS bin is the fundamental rounded to the bin grid; its true maximum may be one
+// bin over, so step to the larger neighbour before interpolating. At most radius
+// steps are taken, which keeps the climb off a neighbouring peak.
+inline size_t climb_to_peak(std::span<const double> log_power, size_t bin, size_t radius = SIZE_MAX) {
+    const size_t start = bin;
+    while (bin > 0 && start - bin < radius && log_power[bin - 1] > log_power[bin]) {
+        --bin;
+    }
+    while (bin + 1 < log_power.size() && bin - start < radius && log_power[bin + 1] > log_power[bin]) {
+        ++bin;
+    }
+    return bin;
+}
+
+} // namespace spectral
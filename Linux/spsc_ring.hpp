@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <stop_token>
+#include "arena.hpp"
+
+// Lock-free single-producer/single-consumer ring buffer.
+// The producer (the PortAudio callback) only copies samples in and never blocks;
+// the consumer (the analysis thread) can sleep until enough samples are queued.
+template<typename T>
+class SpscRing {
+    static constexpr size_t cache_line = 64;
+
+    AlignedBuffer<T> buffer;
+    size_t mask;
+
+    alignas(cache_line) std::atomic<size_t> head{0};       // next write position, owned by the producer
+    alignas(cache_line) std::atomic<size_t> tail{0};       // next read position, owned by the consumer
+    alignas(cache_line) std::atomic<uint32_t> signal{0};    // bumped on every push so the consumer can wait
+    std::atomic<size_t> dropped{0};
+
+public:
+    explicit SpscRing(size_t min_capacity, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : buffer(std::bit_ceil(min_capacity), memory),
+          mask(std::bit_ceil(min_capacity) - 1) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const noexcept { return mask + 1; }
+
+    size_t size() const noexcept {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    // Items the producer had to discard because the consumer fell behind
+    size_t dropped_count() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+    // Producer side. Copies as many items as fit and returns that count.
+    size_t push(std::span<const T> items) noexcept {
+        return push_strided(items.data(), items.size(), 1);
+    }
+
+    // Producer side. Queues items[0], items[stride], ... items[(count - 1) * stride],
+    // which de-interleaves one channel of a multi-channel buffer without a copy.
+    size_t push_strided(const T* items, size_t count, size_t stride) noexcept {
+        const size_t w = head.load(std::memory_order_relaxed);
+        const size_t r = tail.load(std::memory_order_acquire);
+        const size_t accepted = std::min(count, capacity() - (w - r));
+
+        for (size_t i = 0; i < accepted; ++i) {
+            buffer[(w + i) & mask] = items[i * stride];
+        }
+        head.store(w + accepted, std::memory_order_release);
+
+        if (accepted < count) {
+            dropped.fetch_add(count - accepted, std::memory_order_relaxed);
+        }
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+        return accepted;
+    }
+
+    // Consumer side. Copies up to out.size() items and returns that count.
+    size_t pop(std::span<T> out) noexcept {
+        const size_t r = tail.load(std::memory_order_relaxed);
+        const size_t w = head.load(std::memory_order_acquire);
+        const size_t count = std::min(out.size(), w - r);
+
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = buffer[(r + i) & mask];
+        }
+        tail.store(r + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side. Discards up to count queued items without copying them.
+    size_t skip(size_t count) noexcept {
+        const size_t r = tail.load(std::memory_order_relaxed);
+        const size_t w = head.load(std::memory_order_acquire);
+        count = std::min(count, w - r);
+        tail.store(r + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side. Blocks until at least min_items are queued or a stop is requested.
+    // Returns false when woken by the stop request.
+    bool wait_for(size_t min_items, std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            const uint32_t seen = signal.load(std::memory_order_acquire);
+            if (size() >= min_items) {
+                return true;
+            }
+            signal.wait(seen, std::memory_order_acquire);
+        }
+        return false;
+    }
+
+    // Wakes a consumer blocked in wait_for, e.g. after requesting a stop
+    void wake() noexcept {
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_all();
+    }
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <vector>
+#include "pitch_detector.hpp"
+
+// Locked-string tracking: once the string being tuned is known, a bank of sliding DFT
+// bins around its fundamental and first harmonics replaces the full analysis.
+// Each bin costs one complex multiply-add per sample, so with k partials the cost is
+// O(k) per sample instead of an FFT per hop. Frequency comes from the phase advance of
+// each partial over one hop, which is far finer than the bin spacing. The wrapped
+// detector runs only to acquire a string and to reacquire after the lock is lost:
+// the note fades, another string is plucked, or the frames stop being consecutive.
+template<typename Real = double>
+class StringTracker : public PitchDetector<Real> {
+    using Complex = std::complex<double>;
+
+    static constexpr size_t PARTIALS = 3;           // fundamental and the first two harmonics
+    static constexpr double CAPTURE_CENTS = 300.0;  // farther than this from every string: no lock
+    static constexpr double MIN_TONALITY = 0.2;     // share of the energy the partials must hold
+    static constexpr size_t LOSS_HOPS = 3;          // weak hops in a row before the lock is dropped
+    static constexpr size_t RESYNC_HOPS = 256;      // exact recomputation against rounding drift
+
+    // One Hann-windowed sliding DFT: bins at w - d, w, w + d with d = 2 pi / length,
+    // combined as 0.5 X(w) - 0.25 (X(w - d) + X(w + d))
+    struct Partial {
+        size_t harmonic = 1;
+        std::array<double, 3> omega{};
+        std::array<Complex, 3> bins{};
+        std::array<Complex, 3> step{};      // e^{j w}
+        std::array<Complex, 3> expire{};    // e^{j w length}, for the sample leaving the window
+        Complex previous{};                 // windowed value one hop ago
+
+        Complex value() const { return 0.5 * bins[1] - 0.25 * (bins[0] + bins[2]); }
+    };
+
+    std::unique_ptr<PitchDetector<Real>> acquisition;
+    std::pmr::vector<double> strings;
+    std::optional<size_t> pinned;
+    size_t window_size;
+    size_t hop;
+    size_t length;          // samples per sliding DFT: the window minus one hop
+    double sample_rate;
+
+    bool locked = false;
+    double target_hz = 0.0;
+    double center_hz = 0.0;
+    std::array<Partial, PARTIALS> partials;
+    size_t partial_count = 0;
+    double energy = 0.0;    // sum of squares over the sliding DFT span
+    size_t weak_hops = 0;
+    size_t hops_since_sync = 0;
+    std::array<Real, 4> tail{};     // last samples of the previous frame
+
+    static double cents_between(double frequency, double reference) {
+        return 1200.0 * std::log2(frequency / reference);
+    }
+
+    // Centres the bank on a frequency and computes every bin directly over the newest
+    // length samples of the frame: O(length * k), only on lock, drift and resync
+    void sync(std::span<const Real> frame, double frequency) {
+        center_hz = frequency;
+        const double nyquist = sample_rate / 2;
+        const double spacing = 2.0 * std::numbers::pi / static_cast<double>(length);
+        const size_t start = frame.size() - length;
+
+        partial_count = 0;
+        for (size_t h = 1; h <= PARTIALS; ++h) {
+            if ((h * frequency + 2.0 * sample_rate / length) >= nyquist) {
+                break;
+            }
+            auto& partial = partials[partial_count++];
+            partial.harmonic = h;
+            for (size_t b = 0; b < 3; ++b) {
+                const double omega = 2.0 * std::numbers::pi * h * frequency / sample_rate
+                                   + (static_cast<double>(b) - 1.0) * spacing;
+                partial.omega[b] = omega;
+                partial.step[b] = std::polar(1.0, omega);
+                partial.expire[b] = std::polar(1.0, omega * static_cast<double>(length));
+
+                // X_n = sum_m x[n - m] e^{j w m}, m = 0 .. length - 1
+                Complex sum{};
+                for (size_t m = 0; m < length; ++m) {
+                    sum += static_cast<double>(frame[frame.size() - 1 - m]) * std::polar(1.0, omega * static_cast<double>(m));
+                }
+                partial.bins[b] = sum;
+            }
+            partial.previous = partial.value();
+        }
+
+        energy = 0.0;
+        for (size_t i = start; i < frame.size(); ++i) {
+            energy += static_cast<double>(frame[i]) * frame[i];
+        }
+        hops_since_sync = 0;
+        remember_tail(frame);
+    }
+
+    void remember_tail(std::span<const Real> frame) {
+        std::copy(frame.end() - tail.size(), frame.end(), tail.begin());
+    }
+
+    // The new frame must continue the previous one: its samples just before the newest
+    // hop are the previous frame's last ones. Gated or interleaved frames fail this.
+    bool continues(std::span<const Real> frame) const {
+        return std::equal(tail.begin(), tail.end(), frame.end() - hop - tail.size());
+    }
+
+    Result<double> acquire(std::span<const Real> frame) {
+        locked = false;
+        auto frequency = acquisition->analyze(frame);
+        if (!frequency || !(*frequency > 0.0)) {
+            return frequency;
+        }
+
+        std::optional<double> target;
+        if (pinned) {
+            target = strings[*pinned];
+        } else {
+            for (double string : strings) {
+                if (!target || std::abs(cents_between(*frequency, string)) < std::abs(cents_between(*frequency, *target))) {
+                    target = string;
+                }
+            }
+        }
+        if (!target || std::abs(cents_between(*frequency, *target)) > CAPTURE_CENTS) {
+            return frequency;
+        }
+
+        locked = true;
+        target_hz = *target;
+        weak_hops = 0;
+        sync(frame, *frequency);
+        return frequency;
+    }
+
+public:
+    // strings: the open-string frequencies of the tuning; pinned_string locks to one of
+    // them instead of the nearest. The frame must be longer than one hop plus 4 samples.
+    StringTracker(std::unique_ptr<PitchDetector<Real>> detector, std::span<const double> open_strings,
+                  std::optional<size_t> pinned_string, size_t hop_size, double rate,
+                  std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        acquisition(std::move(detector)),
+        strings(open_strings.begin(), open_strings.end(), memory),
+        pinned(pinned_string),
+        window_size(acquisition->size()),
+        hop(hop_size),
+        length(window_size - hop_size),
+        sample_rate(rate) {}
+
+    std::string_view name() const override { return "locked"; }
+
+    size_t size() const override { return window_size; }
+
+    bool is_locked() const { return locked; }
+
+    Result<double> analyze(std::span<const Real> audio_data) override {
+        if (audio_data.size() != window_size) {
+            return std::unexpected(TunerError("Invalid audio buffer size"));
+        }
+        if (!locked || !continues(audio_data)) {
+            return acquire(audio_data);
+        }
+
+        // Slide every bin over the new hop: X_n = x[n] + e^{j w} X_{n-1} - e^{j w L} x[n - L]
+        for (size_t i = window_size - hop; i < window_size; ++i) {
+            const double x = audio_data[i];
+            const double old = audio_data[i - length];
+            energy += x * x - old * old;
+            for (size_t p = 0; p < partial_count; ++p) {
+                auto& partial = partials[p];
+                for (size_t b = 0; b < 3; ++b) {
+                    partial.bins[b] = x + partial.step[b] * partial.bins[b] - partial.expire[b] * old;
+                }
+            }
+        }
+        remember_tail(audio_data);
+
+        // Each partial's phase advance over the hop, less the advance at the centre bin,
+        // is its offset from the centre; the partials are combined by power
+        double weighted = 0.0;
+        double total_power = 0.0;
+        for (size_t p = 0; p < partial_count; ++p) {
+            auto& partial = partials[p];
+            const Complex current = partial.value();
+            const double expected = partial.omega[1] * static_cast<double>(hop);
+            const double deviation = std::arg(current * std::conj(partial.previous) * std::polar(1.0, -expected));
+            const double omega = partial.omega[1] + deviation / static_cast<double>(hop);
+            const double power = std::norm(current);
+            weighted += power * omega * sample_rate / (2.0 * std::numbers::pi * partial.harmonic);
+            total_power += power;
+            partial.previous = current;
+        }
+
+        // A Hann-windowed sinusoid of amplitude A gives |X| = A L / 4 against A^2 L / 2
+        // of energy, so 8 |X|^2 / (L E) is the share of the energy in the partials
+        const double tonality = energy > 0.0 ? 8.0 * total_power / (static_cast<double>(length) * energy) : 0.0;
+        weak_hops = tonality < MIN_TONALITY ? weak_hops + 1 : 0;
+        if (total_power <= 0.0 || weak_hops >= LOSS_HOPS) {
+            return acquire(audio_data);
+        }
+
+        const double frequency = weighted / total_power;
+        if (std::abs(cents_between(frequency, target_hz)) > CAPTURE_CENTS) {
+            return acquire(audio_data);
+        }
+
+        // Recentre once the note drifts half a bin from the bank, and resync periodically
+        if (std::abs(frequency - center_hz) > 0.5 * sample_rate / length || ++hops_since_sync >= RESYNC_HOPS) {
+            sync(audio_data, frequency);
+        }
+        return frequency;
+    }
+};
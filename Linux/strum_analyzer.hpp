@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <vector>
+#include "arena.hpp"
+#include "fft_wisdom.hpp"
+#include "fftw_traits.hpp"
+#include "simd_kernels.hpp"
+#include "spectral_peak.hpp"
+#include "tuner_error.hpp"
+#include "window_functions.hpp"
+
+// Polyphonic analysis of a strum: every string of a tuning is measured from the same
+// frame. The open-string frequencies are priors; each string only searches a narrow
+// region around its own target, scoring candidates by the log power of their first
+// harmonics. Partials that coincide with a partial of another string (the A string's
+// 3rd against the high E, the low E's 3rd against the B) cannot be attributed, so they
+// are masked out of that string's score and measurement. One FFT serves all strings.
+struct StringPitch {
+    double target_hz = 0.0;
+    double frequency = 0.0;
+    bool present = false;       // the string rises clearly above the noise floor
+
+    double cents() const { return 1200.0 * std::log2(frequency / target_hz); }
+};
+
+template<typename Real = double>
+class StrumAnalyzer {
+    using Api = Fftw<Real>;
+    using Complex = typename Api::complex;
+
+    static constexpr size_t HARMONICS = 4;
+    static constexpr size_t MEASURE_PARTIALS = 3;   // higher partials are pulled sharp by inharmonicity
+    static constexpr double SEARCH_CENTS = 150.0;   // tuning range around each target
+    static constexpr double PRESENCE = 4.6;         // 20 dB over the median bin, as a log power ratio
+
+    struct Prior {
+        double target_hz = 0.0;
+        std::array<bool, HARMONICS> masked{};   // partial h + 1 collides with another string
+    };
+
+    size_t window_size;
+    size_t fft_size;
+    double sample_rate;
+    WindowTable<Real> window;
+    AlignedBuffer<Real> input;
+    AlignedBuffer<Complex> output;
+    typename Api::plan plan;    // owned by the plan cache
+    std::pmr::vector<double> log_power;
+    std::pmr::vector<double> scratch;
+    std::pmr::vector<Prior> priors;
+    std::pmr::vector<StringPitch> pitches;
+
+    size_t bin_of(double frequency) const {
+        return static_cast<size_t>(std::lround(frequency * fft_size / sample_rate));
+    }
+
+    // Best candidate bin of a string and the partial it is measured from
+    StringPitch measure(const Prior& prior, double noise_floor) const {
+        const double span = std::exp2(SEARCH_CENTS / 1200.0);
+        const size_t bins = log_power.size();
+        const size_t first = std::max<size_t>(bin_of(prior.target_hz / span), 1);
+        const size_t last = std::min(bin_of(prior.target_hz * span), bins - 1);
+
+        // With every partial masked (duplicate strings), the string is scored on all of them
+        const bool all_masked = std::ranges::all_of(prior.masked, [](bool m) { return m; });
+        auto counts = [&](size_t h) { return all_masked || !prior.masked[h - 1]; };
+
+        auto score = [&](size_t k) {
+            double sum = 0.0;
+            for (size_t h = 1; h <= HARMONICS && h * k < bins; ++h) {
+                if (counts(h)) {
+                    sum += log_power[h * k];
+                }
+            }
+            return sum;
+        };
+
+        // Only a local maximum counts: the highest score at the edge of the region is
+        // usually the flank of a neighbouring string's peak
+        StringPitch pitch{prior.target_hz};
+        size_t best = 0;
+        double best_score = -INFINITY;
+        double previous = score(first - 1);
+        double current = score(first);
+        for (size_t k = first; k <= last; ++k) {
+            const double next = score(k + 1);
+            if (current >= previous && current >= next && current > best_score) {
+                best_score = current;
+                best = k;
+            }
+            previous = current;
+            current = next;
+        }
+        if (!best) {
+            return pitch;
+        }
+
+        size_t partial = 0;
+        size_t partial_bin = 0;
+        for (size_t h = 1; h <= HARMONICS && h * best < bins; ++h) {
+            if (!counts(h) || (partial && h > MEASURE_PARTIALS)) {
+                continue;
+            }
+            // A climb that leaves the string's region has found a neighbour's partial
+            const size_t bin = spectral::climb_to_peak(log_power, h * best, h * (fft_size / window_size));
+            if (bin < h * first || bin > h * last) {
+                continue;
+            }
+            if (!partial || log_power[bin] > log_power[partial_bin]) {
+                partial = h;
+                partial_bin = bin;
+            }
+        }
+        if (!partial) {
+            return pitch;
+        }
+
+        pitch.frequency = spectral::interpolate_peak(log_power, partial_bin) / partial * sample_rate / fft_size;
+        pitch.present = log_power[partial_bin] > noise_floor + PRESENCE
+                     && std::abs(pitch.cents()) <= SEARCH_CENTS;
+        return pitch;
+    }
+
+public:
+    StrumAnalyzer(std::span<const double> strings, size_t size, double rate,
+                  WindowType type = WindowType::hann, size_t zero_padding = 1,
+                  std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        window_size(size),
+        fft_size(size * std::max<size_t>(zero_padding, 1)),
+        sample_rate(rate),
+        window(type, window_size, memory),
+        input(fft_size, memory),
+        output(fft_size / 2 + 1, memory),
+        plan(fft_wisdom::PlanCache<Real>::instance().r2c(static_cast<int>(fft_size))),
+        log_power(fft_size / 2, memory),
+        scratch(fft_size / 2, memory),
+        priors(memory),
+        pitches(strings.size(), memory) {
+
+        if (!plan) {
+            throw std::bad_alloc();
+        }
+        priors.reserve(strings.size());
+
+        // Partials closer than the window's main lobe merge into one peak. Strings tuned
+        // to the same pitch would mask each other completely, so they are not compared.
+        const double lobe_hz = main_lobe_bins(type) * sample_rate / window_size;
+        for (double target : strings) {
+            Prior prior{target};
+            for (size_t h = 1; h <= HARMONICS; ++h) {
+                for (double other : strings) {
+                    if (std::abs(other - target) < lobe_hz) {
+                        continue;
+                    }
+                    for (size_t m = 1; m <= HARMONICS; ++m) {
+                        prior.masked[h - 1] = prior.masked[h - 1] || std::abs(h * target - m * other) < lobe_hz;
+                    }
+                }
+            }
+            priors.push_back(prior);
+        }
+    }
+
+    size_t size() const { return window_size; }
+
+    // One entry per string, in the order of the priors
+    Result<std::span<const StringPitch>> analyze(std::span<const Real> audio_data) {
+        if (audio_data.size() != window_size) {
+            return std::unexpected(TunerError("Invalid audio buffer size"));
+        }
+
+        simd::multiply(audio_data, window.coefficients(), std::span<Real>(input.get(), window_size));
+        Api::execute_r2c(plan, input.get(), output.get());
+        spectral::log_power(output.get(), log_power);
+
+        // The median bin of the band the strings occupy stands in for the noise floor
+        const auto [lowest, highest] = std::ranges::minmax(priors, {}, &Prior::target_hz);
+        const size_t band_begin = std::clamp<size_t>(bin_of(lowest.target_hz / 2), 1, log_power.size() - 1);
+        const size_t band_end = std::clamp<size_t>(bin_of(highest.target_hz * HARMONICS), band_begin + 1, log_power.size());
+        const auto band = std::span(scratch).first(band_end - band_begin);
+        std::copy(log_power.begin() + band_begin, log_power.begin() + band_end, band.begin());
+        std::nth_element(band.begin(), band.begin() + band.size() / 2, band.end());
+        const double noise_floor = band[band.size() / 2];
+
+        // Each string reads the shared spectrum independently
+        for (size_t s = 0; s < priors.size(); ++s) {
+            pitches[s] = measure(priors[s], noise_floor);
+        }
+        return std::span<const StringPitch>(pitches);
+    }
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+// Lock-free hot-path instrumentation. Every update is a relaxed atomic add (plus a
+// CAS loop for the maximum), so the audio callback can record without ever blocking;
+// readers see slightly torn but monotonic values, which is fine for monitoring.
+namespace telemetry {
+
+inline uint64_t now_ns() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+using Counter = std::atomic<uint64_t>;
+
+// Log-linear histogram: values below 4 are exact, above that each power of two is
+// split into 4 buckets, so a quantile is within 25% of the true value
+class Histogram {
+    static constexpr size_t sub_buckets = 4;
+    static constexpr size_t bucket_count = 64 * sub_buckets;
+
+    std::array<Counter, bucket_count> buckets{};
+    Counter total{0};
+    Counter sum{0};
+    Counter maximum{0};
+
+    static constexpr size_t bucket_of(uint64_t value) noexcept {
+        if (value < sub_buckets) {
+            return value;
+        }
+        const size_t exponent = std::bit_width(value) - 1;
+        return exponent * sub_buckets + ((value >> (exponent - 2)) & (sub_buckets - 1));
+    }
+
+    // Largest value that lands in the bucket
+    static constexpr uint64_t upper_bound(size_t bucket) noexcept {
+        if (bucket < sub_buckets) {
+            return bucket;
+        }
+        const size_t exponent = bucket / sub_buckets;
+        const uint64_t sub = bucket % sub_buckets;
+        return ((sub_buckets + sub + 1) << (exponent - 2)) - 1;
+    }
+
+public:
+    void record(uint64_t value) noexcept {
+        buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (value > seen && !maximum.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const noexcept { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const noexcept { return maximum.load(std::memory_order_relaxed); }
+
+    double mean() const noexcept {
+        const uint64_t n = count();
+        return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+    }
+
+    uint64_t quantile(double q) const noexcept {
+        const uint64_t n = count();
+        if (n == 0) {
+            return 0;
+        }
+        const uint64_t rank = static_cast<uint64_t>(q * (n - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < bucket_count; ++b) {
+            seen += buckets[b].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::min(upper_bound(b), max());
+            }
+        }
+        return max();
+    }
+
+    // {"count":..,"mean":..,"p50":..,"p99":..,"p999":..,"max":..}
+    template<typename Out>
+    Out format_json(Out out) const {
+        return std::format_to(out, "{{\"count\":{},\"mean\":{:.1f},\"p50\":{},\"p99\":{},\"p999\":{},\"max\":{}}}",
+            count(), mean(), quantile(0.50), quantile(0.99), quantile(0.999), max());
+    }
+};
+
+// Counters and latencies of the live pipeline, shared by the audio callback, the
+// analysis workers and the UI thread
+struct Stats {
+    // Audio callback (real-time thread)
+    Counter callbacks{0};
+    Counter input_overflows{0};     // xruns reported as paInputOverflow
+    Counter input_underflows{0};
+    Histogram callback_ns;          // time spent inside the callback
+    Histogram deadline_permille;    // callback time as a share of its buffer period
+    Histogram input_latency_us;     // ADC time of the buffer to callback start
+    Histogram queue_depth;          // samples waiting for analysis after each push
+
+    // Analysis workers
+    Counter windows{0};
+    Counter gated{0};               // windows skipped as silence or pick attack
+    Counter onsets{0};              // notes started, as seen by the gate
+    Histogram detector_ns;          // detector proper: windowing, FFTs and peak search
+    Histogram detection_ns;         // whole window: gate, detector and note mapping
+
+    // UI thread
+    Histogram render_ns;
+
+    // One JSON object per call; dropped is the ring overflow count kept by the queues
+    std::string to_json(uint64_t dropped_samples) const {
+        std::string json;
+        auto out = std::back_inserter(json);
+        auto counter = [&](std::string_view name, uint64_t value) {
+            out = std::format_to(out, "\"{}\":{},", name, value);
+        };
+        auto histogram = [&](std::string_view name, const Histogram& h, std::string_view separator = ",") {
+            out = std::format_to(out, "\"{}\":", name);
+            out = h.format_json(out);
+            out = std::format_to(out, "{}", separator);
+        };
+
+        out = std::format_to(out, "{{\"time_ms\":{},", now_ns() / 1'000'000);
+        counter("callbacks", callbacks.load(std::memory_order_relaxed));
+        counter("xruns", input_overflows.load(std::memory_order_relaxed));
+        counter("underflows", input_underflows.load(std::memory_order_relaxed));
+        counter("dropped_samples", dropped_samples);
+        counter("windows", windows.load(std::memory_order_relaxed));
+        counter("gated", gated.load(std::memory_order_relaxed));
+        counter("onsets", onsets.load(std::memory_order_relaxed));
+        histogram("callback_ns", callback_ns);
+        histogram("deadline_permille", deadline_permille);
+        histogram("input_latency_us", input_latency_us);
+        histogram("queue_depth", queue_depth);
+        histogram("detector_ns", detector_ns);
+        histogram("detection_ns", detection_ns);
+        histogram("render_ns", render_ns, "}");
+        return json;
+    }
+};
+
+} // namespace telemetry
@@ -1,119 +1,287 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <string>
 #include <cmath>
+#include <cstdlib>
+#include <charconv>
+#include <system_error>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <stop_token>
 #include <portaudio.h>
-#include <fftw3.h>
+#include "fft_analyzer.hpp"
+#include "fft_wisdom.hpp"
+#include "spsc_ring.hpp"
+#include "note_mapping.hpp"
+#include "simd_kernels.hpp"
+#include "window_functions.hpp"
+#include "audio_device.hpp"
+#include "decimator.hpp"
+#include "note_gate.hpp"
+#include "pitch_tracker.hpp"
+#include "tunings.hpp"
+#include "event_loop.hpp"
+#include "realtime.hpp"
 
-// Define the target frequencies for each guitar string (standard tuning)
-std::vector<double> string_tunings = { 329.63, 246.94, 196.00, 146.83, 110.00, 82.41 };
+// Analysis precision: float (fftwf, -lfftw3f) by default, double (fftw, -lfftw3)
+// when built with -DTUNER_DOUBLE_PRECISION
+#ifdef TUNER_DOUBLE_PRECISION
+typedef double Sample;
+#else
+typedef float Sample;
+#endif
 
-// Function to calculate the closest note to the given frequency
-std::string closest_note_frequency(double frequency)
-{
-    std::vector<std::pair<std::string, double>> notes = {
-        { "C0", 16.35 }, { "C#0", 17.32 }, { "D0", 18.35 }, { "D#0", 19.45 }, { "E0", 20.60 }, { "F0", 21.83 }, { "F#0", 23.12 }, { "G0", 24.50 }, { "G#0", 25.96 },
-        { "A0", 27.50 }, { "A#0", 29.14 }, { "B0", 30.87 },
-        { "C1", 32.70 }, { "C#1", 34.65 }, { "D1", 36.71 }, { "D#1", 38.89 }, { "E1", 41.20 }, { "F1", 43.65 }, { "F#1", 46.25 }, { "G1", 49.00 }, { "G#1", 51.91 },
-        { "A1", 55.00 }, { "A#1", 58.27 }, { "B1", 61.74 },
-        { "C2", 65.41 }, { "C#2", 69.30 }, { "D2", 73.42 }, { "D#2", 77.78 }, { "E2", 82.41 }, { "F2", 87.31 }, { "F#2", 92.50 }, { "G2", 98.00 }, { "G#2", 103.83 },
-        { "A2", 110.00 }, { "A#2", 116.54 }, { "B2", 123.47 },
-        { "C3", 130.81 }, { "C#3", 138.59 }, { "D3", 146.83 }, { "D#3", 155.56 }, { "E3", 164.81 }, { "F3", 174.61 }, { "F#3", 185.00 }, { "G3", 196.00 }, { "G#3", 207.65 },
-        { "A3", 220.00 }, { "A#3", 233.08 }, { "B3", 246.94 },
-        { "C4", 261.63 }, { "C#4", 277.18 }, { "D4", 293.66 }, { "D#4", 311.13 }, { "E4", 329.63 }, { "F4", 349.23 }, { "F#4", 369.99 }, { "G4", 392.00 }, { "G#4", 415.30 },
-        { "A4", 440.00 }, { "A#4", 466.16 }, { "B4", 493.88 },
-        { "C5", 523.25 }, { "C#5", 554.37 }, { "D5", 587.33 }, { "D#5", 622.25 }, { "E5", 659.25 }, { "F5", 698.46 }, { "F#5", 739.99 }, { "G5", 783.99 }, { "G#5", 830.61 },
-        { "A5", 880.00 }, { "A#5", 932.33 }, { "B5", 987.77 },
-        { "C6", 1046.50 }, { "C#6", 1108.73 }, { "D6", 1174.66 }, { "D#6", 1244.51 }, { "E6", 1318.51 }, { "F6", 1396.91 }, { "F#6", 1479.98 }, { "G6", 1567.98 }, { "G#6", 1661.22 },
-        { "A6", 1760.00 }, { "A#6", 1864.66 }, { "B6", 1975.53 },
-        { "C7", 2093.00 }, { "C#7", 2217.46 }, { "D7", 2349.32 }, { "D#7", 2489.02 }, { "E7", 2637.02 }, { "F7", 2793.83 }, { "F#7", 2959.96 }, { "G7", 3135.96 }, { "G#7", 3322.44 }
-    };
-
-    std::string closest_note;
-    double min_difference = std::numeric_limits<double>::max();
-
-    for (const auto& note : notes) {
-        double difference = std::abs(note.second - frequency);
-        if (difference < min_difference) {
-            min_difference = difference;
-            closest_note = note.first;
-        }
-    }
-
-    return closest_note;
-}
+// Guitar strings in standard tuning, as compile-time data
+using StandardTuning = tunings::Strings<tunings::Guitar>;
 
-// Function to compute the FFT and return the dominant frequency
-double compute_fft(double* audio_data, unsigned int num_samples, double sampleRate)
+// Function to format and print the results
+void print_detection_results(double frequency, const NoteMatch& closest_note, double confidence, size_t string)
 {
-    // Create FFTW plan
-    fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * num_samples);
-    fftw_plan plan = fftw_plan_dft_r2c_1d(num_samples, audio_data, out, FFTW_ESTIMATE);
-
-    // Execute FFT
-    fftw_execute(plan);
-
-    // Find the dominant frequency
-    double max_magnitude = 0.0;
-    double dominant_frequency = 0.0;
-    for (unsigned int i = 0; i < num_samples / 2; ++i) {
-        double real = out[i][0];
-        double imag = out[i][1];
-        double magnitude = sqrt(real * real + imag * imag);
-        if (magnitude > max_magnitude) {
-            max_magnitude = magnitude;
-            dominant_frequency = (i * sampleRate) / num_samples;
-        }
+    std::cout << std::fixed << std::setprecision(2);  // Fixed-point notation with 2 decimal places
+    std::cout << "Detected Frequency: " << frequency << " Hz (confidence " << std::setprecision(0)
+              << confidence * 100.0 << "%)" << std::setprecision(2) << std::endl;
+    if (closest_note.is_valid()) {
+        std::cout << "Closest Note: " << NoteMapper::name(closest_note) << closest_note.octave
+                  << " (" << std::showpos << closest_note.cents << std::noshowpos << " cents)" << std::endl;
+    } else {
+        std::cout << "Closest Note: " << NoteMapper::name(closest_note) << std::endl;
+    }
+    if (frequency > 0.0) {
+        std::cout << "Closest String: " << string + 1 << " (" << StandardTuning::preset.notes[string] << ")" << std::endl;
     }
-
-    // Clean up
-    fftw_destroy_plan(plan);
-    fftw_free(out);
-
-    return dominant_frequency;
 }
 
-// Function to format and print the results
-void print_detection_results(double frequency, const std::string& closest_note)
+// A whole argument as a number; "12x", "" and out-of-range values are rejected
+template<typename T>
+bool parse_number(const char* text, T& value)
 {
-    std::cout << std::fixed << std::setprecision(2);  // Fixed-point notation with 2 decimal places
-    std::cout << "Detected Frequency: " << frequency << " Hz" << std::endl;
-    std::cout << "Closest Note: " << closest_note << std::endl;
+    const char* end = text + std::strlen(text);
+    auto [last, ec] = std::from_chars(text, end, value);
+    return ec == std::errc{} && last == end;
 }
 
-// Callback function for audio input processing
+// State shared with the audio callback: the sample queue, the xrun count and the
+// callback thread's real-time promotion, done on its first call
+struct CaptureState
+{
+    SpscRing<float> ring;
+    std::atomic<unsigned long> input_overflows{0};
+    realtime::Options realtime;
+    bool audio_promoted = false;
+    std::atomic<int> audio_rt_error{0};
+
+    explicit CaptureState(unsigned int capacity) : ring(capacity) {}
+};
+
+// Callback function for audio input processing: only queues the samples for the analysis thread
 int process_audio_input(const void* inputBuffer, void* outputBuffer,
     unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo,
     PaStreamCallbackFlags statusFlags, void* userData)
 {
-    float* float_audio_data = (float*)inputBuffer;
-    unsigned int num_samples = framesPerBuffer;
+    const float* float_audio_data = (const float*)inputBuffer;
+    CaptureState* capture = (CaptureState*)userData;
 
-    // Convert float audio data to double
-    double* audio_data = new double[num_samples];
-    for (unsigned int i = 0; i < num_samples; ++i) {
-        audio_data[i] = static_cast<double>(float_audio_data[i]);
+    if (capture->realtime.enabled && !capture->audio_promoted) {
+        capture->audio_promoted = true;
+        capture->audio_rt_error.store(realtime::promote_audio_thread(capture->realtime), std::memory_order_relaxed);
     }
 
-    // Perform pitch analysis
-    double sampleRate = 44100;
-    double frequency = compute_fft(audio_data, num_samples, sampleRate);
+    // The device dropped input before this buffer
+    if (statusFlags & paInputOverflow) {
+        capture->input_overflows.fetch_add(1, std::memory_order_relaxed);
+    }
 
-    std::string closest_note = closest_note_frequency(frequency);
+    capture->ring.push(std::span<const float>(float_audio_data, framesPerBuffer));
 
-    // Print the results
-    print_detection_results(frequency, closest_note);
+    return paContinue;
+}
 
-    delete[] audio_data;
+// Frames quieter than this are silence whatever the learned noise floor (-60 dBFS)
+const double MIN_AMPLITUDE = 0.001;
 
-    return paContinue;
+// Analysis thread: waits for a full FFT frame, analyzes it and prints the results.
+// When decimating, a frame is decimator.factor() times as many device samples,
+// band-limited and downsampled to the analyzer's size first. Frames of silence and
+// the pick attack are neither transformed nor printed.
+void analysis_loop(std::stop_token stop, FFTAnalyzer<Sample>& analyzer, double analysis_rate, Decimator& decimator,
+    SpscRing<float>& ring, const NoteMapper& mapper, const realtime::Options& rt)
+{
+    std::stop_callback wake_on_stop(stop, [&ring] { ring.wake(); });
+    if (rt.enabled) {
+        if (int rt_error = realtime::promote_analysis_thread(rt, 0)) {
+            std::cerr << "Analysis runs without real-time scheduling: " << std::strerror(rt_error) << std::endl;
+        }
+    }
+
+    const size_t frame_samples = analyzer.size() * decimator.factor();
+    std::vector<float> float_audio_data(frame_samples);
+    std::vector<float> decimated(analyzer.size());
+#ifdef TUNER_DOUBLE_PRECISION
+    std::vector<Sample> converted(analyzer.size());
+#endif
+    NoteGate gate(analyzer.size(), analysis_rate, MIN_AMPLITUDE);
+    PitchTracker tracker;
+
+    while (ring.wait_for(frame_samples, stop)) {
+        ring.pop(float_audio_data);
+
+        std::span<const float> frame = float_audio_data;
+        if (decimator.factor() > 1) {
+            frame = std::span<const float>(decimated).first(decimator.process(float_audio_data, decimated));
+        }
+        const bool open = gate.update(frame);
+        if (gate.onset()) {
+            tracker.reset();
+        }
+        if (!open) {
+            continue;
+        }
+
+        // Single precision analyzes the captured samples in place; a double build widens them first
+#ifdef TUNER_DOUBLE_PRECISION
+        simd::convert(frame, std::span<Sample>(converted));
+        Result<double> frequency = analyzer.analyze(converted);
+#else
+        Result<double> frequency = analyzer.analyze(frame);
+#endif
+        if (!frequency) {
+            continue;
+        }
+
+        // Perform pitch analysis, smoothed over the frames of the note
+        PitchTracker::Estimate estimate = tracker.update(*frequency);
+
+        NoteMatch closest_note = mapper.nearest(estimate.frequency);
+        const size_t string = StandardTuning::nearest(estimate.frequency * 440.0 / mapper.reference());
+
+        // Print the results
+        print_detection_results(estimate.frequency, closest_note, estimate.confidence, string);
+    }
 }
 
-int main()
+// Stream parameters; the FFT analyzer is planned for exactly ANALYSIS_FRAMES at the rate
+// the device opens with, while the device can use much smaller buffers since the ring
+// decouples the two
+const unsigned int ANALYSIS_FRAMES = 2048;
+const unsigned int DEVICE_FRAMES = 256;
+const unsigned int RING_CAPACITY = ANALYSIS_FRAMES * 16;
+
+int main(int argc, char* argv[])
 {
     PaStream* stream;
     PaError error;
 
+    // --patient trades a slower startup for a faster plan
+    unsigned int plan_flags = FFTW_MEASURE;
+    bool generate_wisdom = false;
+    double a4_hz = NoteMapper::default_a4_hz;
+    WindowType window_type = WindowType::hann;
+    bool list_devices = false;
+    unsigned int decimation = 1;
+    audio_device::InputRequest request;
+    realtime::Options rt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--patient") {
+            plan_flags = FFTW_PATIENT;
+            continue;
+        }
+        if (arg == "--generate-wisdom") {
+            generate_wisdom = true;
+            continue;
+        }
+        if (arg == "--list-devices") {
+            list_devices = true;
+            continue;
+        }
+        if (arg == "--realtime") {
+            rt.enabled = true;
+            continue;
+        }
+
+        // Everything else takes a value
+        if (arg != "--a4" && arg != "--window" && arg != "--device" && arg != "--rate" && arg != "--latency"
+            && arg != "--decimate" && arg != "--rt-priority" && arg != "--audio-cpus" && arg != "--analysis-cpus") {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        const char* value = argv[++i];
+        bool valid = true;
+        if (arg == "--a4") {
+            valid = parse_number(value, a4_hz);
+        } else if (arg == "--window") {
+            auto type = parse_window_type(value);
+            if (!type) {
+                std::cerr << "Unknown window function: " << value << std::endl;
+                return 1;
+            }
+            window_type = *type;
+        } else if (arg == "--device") {
+            request.device = value;
+        } else if (arg == "--rate") {
+            valid = parse_number(value, request.sample_rate) && request.sample_rate >= 0.0;
+        } else if (arg == "--latency") {
+            valid = parse_number(value, request.latency_ms) && request.latency_ms >= 0.0;
+        } else if (arg == "--decimate") {
+            valid = parse_number(value, decimation);
+        } else if (arg == "--rt-priority") {
+            valid = parse_number(value, rt.priority);
+        } else {
+            std::vector<int> cpus = realtime::parse_cpus(value);
+            if (cpus.empty()) {
+                std::cerr << "Invalid CPU list for " << arg << ": " << value << std::endl;
+                return 1;
+            }
+            (arg == "--audio-cpus" ? rt.audio_cpus : rt.analysis_cpus) = std::move(cpus);
+        }
+        if (!valid) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    if (!(a4_hz > 0.0)) {
+        std::cerr << "Invalid A4 reference frequency" << std::endl;
+        return 1;
+    }
+    if (decimation != 1 && decimation != 2 && decimation != 4 && decimation != 8) {
+        std::cerr << "Decimation must be 1, 2, 4 or 8" << std::endl;
+        return 1;
+    }
+    if (rt.priority < 1 || rt.priority > 98) {
+        std::cerr << "Real-time priority must be between 1 and 98" << std::endl;
+        return 1;
+    }
+    NoteMapper mapper(a4_hz);
+
+    // Pre-plan every supported window size and exit
+    if (generate_wisdom) {
+        fft_wisdom::load<Sample>();
+        if (!fft_wisdom::generate<Sample>(FFTW_PATIENT)) {
+            std::cerr << "FFTW wisdom generation error" << std::endl;
+            return 1;
+        }
+        std::cout << "FFTW wisdom written to " << fft_wisdom::cache_path<Sample>().string() << std::endl;
+        return 0;
+    }
+
+    CaptureState capture(RING_CAPACITY);
+    capture.realtime = rt;
+
+    // The main thread waits in the event loop. It blocks SIGINT and SIGTERM for every
+    // thread started after it, PortAudio's included, so it comes first.
+    EventLoop events(true);
+    if (!events.is_valid()) {
+        std::cerr << "Event loop creation error" << std::endl;
+        return 1;
+    }
+
     // Initialize PortAudio
     error = Pa_Initialize();
     if (error != paNoError) {
@@ -121,15 +289,48 @@ int main()
         return 1;
     }
 
-    // Open the microphone stream
-    error = Pa_OpenDefaultStream(&stream, 1, 0, paFloat32, 44100, paFramesPerBufferUnspecified,
-        process_audio_input, nullptr);
+    if (list_devices) {
+        audio_device::list_inputs(std::cout);
+        Pa_Terminate();
+        return 0;
+    }
+
+    // Open the microphone stream on the preferred (or requested) input device
+    audio_device::OpenedInput input;
+    error = audio_device::open_input(request, DEVICE_FRAMES, process_audio_input, &capture, &stream, &input);
     if (error != paNoError) {
         std::cerr << "PortAudio stream open error: " << Pa_GetErrorText(error) << std::endl;
         return 1;
     }
 
-    // Start the stream
+    // Cached wisdom makes the measured plan below nearly free; it is saved back on exit
+    fft_wisdom::Session<Sample> wisdom;
+
+    // Plan the FFT once, for the rate the device opened with, before the stream starts calling back.
+    // Decimating keeps the frame's duration, and so the resolution, with a factor times smaller FFT.
+    // The analyzer takes its plan from the shared cache, so planning it here first applies --patient.
+    const unsigned int analysis_frames = ANALYSIS_FRAMES / decimation;
+    const double analysis_rate = input.sample_rate / decimation;
+    if (!fft_wisdom::PlanCache<Sample>::instance().r2c(analysis_frames, plan_flags)) {
+        std::cerr << "FFTW plan creation error" << std::endl;
+        return 1;
+    }
+    FFTAnalyzer<Sample> analyzer(analysis_frames, analysis_rate, window_type);
+
+    // With --realtime, lock everything allocated so far (and since) in RAM, so the stream
+    // starts without page faults
+    if (rt.enabled) {
+        if (int rt_error = realtime::lock_memory()) {
+            std::cerr << "Memory is not locked, page faults may delay the analysis: " << std::strerror(rt_error)
+                      << std::endl;
+        }
+    }
+
+    // Start the analysis thread, then the stream
+    Decimator decimator(decimation, analysis_rate);
+    std::jthread analysis_thread(analysis_loop, std::ref(analyzer), analysis_rate, std::ref(decimator),
+        std::ref(capture.ring), std::cref(mapper), std::cref(rt));
+
     error = Pa_StartStream(stream);
     if (error != paNoError) {
         std::cerr << "PortAudio stream start error: " << Pa_GetErrorText(error) << std::endl;
@@ -137,11 +338,28 @@ int main()
     }
 
     std::cout << "Guitar Tuner App" << std::endl;
+    if (const PaDeviceInfo* info = Pa_GetDeviceInfo(input.device)) {
+        std::cout << "Input: " << (info->name ? info->name : "?") << " [" << audio_device::host_api_name(*info)
+                  << "], " << input.sample_rate << " Hz, " << input.latency_ms << " ms" << std::endl;
+    }
     std::cout << "Listening for guitar notes..." << std::endl;
-    std::cout << "Press Enter to quit..." << std::endl;
+    std::cout << "Press Enter or Ctrl-C to quit..." << std::endl;
 
-    // Wait for Enter key to quit
-    std::cin.ignore();
+    // Sleep until Enter or a signal. When stdin is not a terminal its end means
+    // nothing, so the tuner keeps running until it is signalled.
+    for (bool quit = false; !quit;) {
+        const EventLoop::Events ready = events.wait();
+        quit = ready.signal != 0;
+        if (ready.input && !quit) {
+            char c = 0;
+            const ssize_t n = read(STDIN_FILENO, &c, 1);
+            if (n == 0 && !isatty(STDIN_FILENO)) {
+                events.ignore_input();
+            } else {
+                quit = n <= 0 || c == '\n';
+            }
+        }
+    }
 
     // Stop and close the stream
     error = Pa_StopStream(stream);
@@ -150,6 +368,16 @@ int main()
         return 1;
     }
 
+    analysis_thread.request_stop();
+    analysis_thread.join();
+
+    if (int rt_error = capture.audio_rt_error.load(std::memory_order_relaxed)) {
+        std::cerr << "The audio callback ran without real-time scheduling: " << std::strerror(rt_error) << std::endl;
+    }
+
+    std::cout << "Input overflows: " << capture.input_overflows.load()
+              << ", samples dropped: " << capture.ring.dropped_count() << std::endl;
+
     error = Pa_CloseStream(stream);
     if (error != paNoError) {
         std::cerr << "PortAudio stream close error: " << Pa_GetErrorText(error) << std::endl;
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "adaptive_window.hpp"
+#include "note_gate.hpp"
+#include "note_mapping.hpp"
+#include "pitch_detectors.hpp"
+#include "shared_results.hpp"
+#include "simd_kernels.hpp"
+#include "string_tracker.hpp"
+#include "strum_analyzer.hpp"
+#include "telemetry.hpp"
+#include "tuner_settings.hpp"
+#include "tunings.hpp"
+
+// Modern audio buffer using std::span
+template<typename Real = double>
+class AudioBuffer {
+    std::pmr::vector<Real> data;
+public:
+    explicit AudioBuffer(size_t size, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : data(size, memory) {}
+    
+    std::span<Real> get_span() { return std::span(data); }
+    std::span<const Real> get_span() const { return std::span(data); }
+    
+    void from_float_buffer(std::span<const float> input) {
+        simd::convert(input, data);
+    }
+};
+
+// The configured detector, wrapped in a string tracker in locked-string mode. With an
+// adaptive window it is a bank of detectors, one per size; a window shorter than a hop
+// would skip samples, so none is.
+inline std::unique_ptr<PitchDetector<Sample>> make_detector(const TunerSettings& settings, double sample_rate,
+                                                            std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    if (settings.adaptive_cents > 0.0) {
+        return std::make_unique<AdaptiveWindow<Sample>>(settings.window_size, settings.hop_size, sample_rate,
+                                                        settings.adaptive_cents, [&](size_t size) {
+            return make_pitch_detector<Sample>(settings.detector, size, sample_rate, settings.window, settings.peak, memory);
+        }, memory);
+    }
+    if (!settings.lock_preset) {
+        return make_pitch_detector<Sample>(settings.detector, settings.window_size, sample_rate, settings.window,
+                                           settings.peak, memory);
+    }
+    
+    // Max picking reads a low string's 2nd harmonic and would lock onto the wrong string
+    auto peak = settings.peak;
+    peak.picking = PeakPicking::hps;
+    auto acquisition = make_pitch_detector<Sample>(settings.detector, settings.window_size, sample_rate,
+                                                   settings.window, peak, memory);
+    
+    const auto strings = TuningConfig::strings(*settings.lock_preset, settings.temperament);
+    const auto pinned = settings.lock_string ? std::optional<size_t>(settings.lock_string - 1) : std::nullopt;
+    return std::make_unique<StringTracker<Sample>>(std::move(acquisition), strings, pinned, settings.hop_size,
+                                                   sample_rate, memory);
+}
+
+// Strum mode analyzer for the preset's strings; null outside strum mode
+inline std::unique_ptr<StrumAnalyzer<Sample>> make_strum_analyzer(const TunerSettings& settings, double sample_rate,
+                                                                  std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    if (!settings.strum_preset) {
+        return nullptr;
+    }
+    // The partials of all the strings sit a few bins apart, so the spectrum is always
+    // sampled at least 4x finer than the window
+    return std::make_unique<StrumAnalyzer<Sample>>(TuningConfig::strings(*settings.strum_preset, settings.temperament),
+                                                   settings.window_size, sample_rate, settings.window,
+                                                   std::max<size_t>(settings.peak.zero_padding, 4), memory);
+}
+
+// Latest analysis result, handed from the analysis thread to the UI thread
+struct TunerReading {
+    double frequency = 0.0;
+    NoteMatch note;
+    double confidence = 0.0;    // live readings after smoothing; 0 to 1
+    
+    SharedReading to_shared() const {
+        return {frequency, note.target_hz, note.cents, confidence, note.note_index, note.octave, telemetry::now_ns()};
+    }
+    
+    static TunerReading from_shared(const SharedReading& shared) {
+        return {shared.frequency, {shared.note_index, shared.octave, shared.target_hz, shared.cents}, shared.confidence};
+    }
+};
+
+static_assert(TunerSettings::max_channels <= SharedSegment::MAX_ROWS && tunings::max_strings <= SharedSegment::MAX_ROWS);
+
+// Windows quieter than this are silence whatever the learned noise floor (-60 dBFS)
+inline constexpr double MIN_AMPLITUDE = 0.001;
+
+// Gates, detects and maps one analysis window; shared by the live and offline pipelines.
+// Returns nothing for windows the gate holds back (silence and pick attacks) and
+// frames the detector rejects.
+// With stats, the window is counted and the detector and whole-window times recorded.
+template<typename Window>
+std::optional<TunerReading> analyze_window(PitchDetector<Sample>& detector, AudioBuffer<Sample>& buffer,
+                                           const NoteMapper& mapper, NoteGate& gate, Window window,
+                                           telemetry::Stats* stats = nullptr) {
+    const uint64_t start = stats ? telemetry::now_ns() : 0;
+    if (stats) {
+        stats->windows.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    const bool open = gate.update(window);
+    if (stats && gate.onset()) {
+        stats->onsets.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!open) {
+        if (stats) {
+            stats->gated.fetch_add(1, std::memory_order_relaxed);
+        }
+        return std::nullopt;
+    }
+    
+    // Single precision analyzes the captured samples in place
+    Result<double> freq;
+    const uint64_t detect_start = stats ? telemetry::now_ns() : 0;
+    if constexpr (std::is_same_v<Sample, float>) {
+        freq = detector.analyze(window);
+    } else {
+        buffer.from_float_buffer(window);
+        freq = detector.analyze(buffer.get_span());
+    }
+    if (stats) {
+        stats->detector_ns.record(telemetry::now_ns() - detect_start);
+    }
+    
+    if (!freq) {
+        return std::nullopt;
+    }
+    TunerReading reading{*freq, mapper.nearest(*freq)};
+    if (stats) {
+        stats->detection_ns.record(telemetry::now_ns() - start);
+    }
+    return reading;
+}
+
+// One reading per string of the strum preset, up to the largest instrument; strings
+// not sounding have no note
+using StrumReading = std::array<TunerReading, tunings::max_strings>;
+
+// Strum counterpart of analyze_window. Each string's note is its open-string target,
+// with the cents measured against the preset frequency rather than equal temperament.
+template<typename Window>
+std::optional<StrumReading> analyze_strum(StrumAnalyzer<Sample>& analyzer, AudioBuffer<Sample>& buffer,
+                                          const NoteMapper& mapper, NoteGate& gate, Window window,
+                                          telemetry::Stats* stats = nullptr) {
+    const uint64_t start = stats ? telemetry::now_ns() : 0;
+    if (stats) {
+        stats->windows.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    const bool open = gate.update(window);
+    if (stats && gate.onset()) {
+        stats->onsets.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!open) {
+        if (stats) {
+            stats->gated.fetch_add(1, std::memory_order_relaxed);
+        }
+        return std::nullopt;
+    }
+    
+    Result<std::span<const StringPitch>> pitches;
+    const uint64_t detect_start = stats ? telemetry::now_ns() : 0;
+    if constexpr (std::is_same_v<Sample, float>) {
+        pitches = analyzer.analyze(window);
+    } else {
+        buffer.from_float_buffer(window);
+        pitches = analyzer.analyze(buffer.get_span());
+    }
+    if (stats) {
+        stats->detector_ns.record(telemetry::now_ns() - detect_start);
+    }
+    if (!pitches) {
+        return std::nullopt;
+    }
+    
+    StrumReading readings{};
+    for (size_t s = 0; s < std::min(readings.size(), pitches->size()); ++s) {
+        const auto& pitch = (*pitches)[s];
+        if (pitch.present) {
+            NoteMatch note = mapper.nearest(pitch.target_hz);
+            note.target_hz = pitch.target_hz;
+            note.cents = pitch.cents();
+            readings[s] = {pitch.frequency, note};
+        }
+    }
+    if (stats) {
+        stats->detection_ns.record(telemetry::now_ns() - start);
+    }
+    return readings;
+}
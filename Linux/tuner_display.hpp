@@ -0,0 +1,373 @@
+#pragma once
+
+#include <ncurses.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "event_loop.hpp"
+#include "note_mapping.hpp"
+#include "shared_results.hpp"
+#include "telemetry.hpp"
+#include "tuner_analysis.hpp"
+#include "tuner_error.hpp"
+#include "tuner_settings.hpp"
+
+// Modern display using RAII.
+// Each frame is diffed against what is already on screen: only lines and meter
+// cells that changed are written, the windows are staged with wnoutrefresh, and
+// present() sends everything to the terminal in a single doupdate.
+class TunerDisplay {
+    struct WindowDeleter {
+        void operator()(WINDOW* w) const { delwin(w); }
+    };
+    
+    enum class Layout { none, single, channels, strings };
+    
+    static constexpr int METER_WIDTH = 58;
+    static constexpr int CHANNEL_METER_COLUMN = 36;
+    static constexpr int CHANNEL_METER_WIDTH = 41;   // +-50 cents, centre mark at 20
+    
+    std::unique_ptr<WINDOW, WindowDeleter> main_win;
+    std::unique_ptr<WINDOW, WindowDeleter> meter_win;
+    std::unique_ptr<WINDOW, WindowDeleter> stats_win;
+    
+    // What is currently drawn
+    Layout layout = Layout::none;
+    std::vector<std::string> main_lines;
+    std::vector<int> needles;           // per meter: column * 4 + colour pair, -1 if none
+    std::vector<std::string> stats_lines;
+    bool stats_visible = false;
+    bool staged = false;                // windows were staged since the last present()
+    std::string title;                  // drawn into the top border of the main window
+    
+    static std::string format_us(uint64_t ns) {
+        return std::format("{:.1f}us", ns / 1000.0);
+    }
+    
+    // Writes a line only if it differs from what is drawn there, padding it so a
+    // shorter value fully overwrites a longer one
+    static bool put(WINDOW* win, int row, int col, std::string& drawn, std::string text) {
+        if (text == drawn) {
+            return false;
+        }
+        std::string padded = text;
+        padded.resize(std::max(text.size(), drawn.size()), ' ');
+        mvwaddnstr(win, row, col, padded.c_str(), static_cast<int>(padded.size()));
+        drawn = std::move(text);
+        return true;
+    }
+    
+    // Moves a meter needle, restoring the cell it leaves; fill(x) is the idle cell
+    template<typename Fill>
+    static bool move_needle(WINDOW* win, int row, int col, int& drawn, int position, int color, Fill&& fill) {
+        const int state = position * 4 + color;
+        if (state == drawn) {
+            return false;
+        }
+        if (drawn >= 0) {
+            mvwaddch(win, row, col + drawn / 4, fill(drawn / 4));
+        }
+        wattron(win, COLOR_PAIR(color));
+        mvwaddch(win, row, col + position, '|');
+        wattroff(win, COLOR_PAIR(color));
+        drawn = state;
+        return true;
+    }
+    
+    void stage(WINDOW* win) {
+        wnoutrefresh(win);
+        staged = true;
+    }
+    
+    // Draws the static parts of a layout once; later frames only touch what changes
+    void set_layout(Layout next, size_t rows) {
+        if (layout == next && main_lines.size() == rows) {
+            return;
+        }
+        layout = next;
+        main_lines.assign(rows, {});
+        
+        werase(main_win.get());
+        box(main_win.get(), 0, 0);
+        if (!title.empty()) {
+            mvwaddnstr(main_win.get(), 0, 2, title.c_str(), 76);
+        }
+        
+        if (layout == Layout::single) {
+            needles.assign(1, -1);
+            werase(meter_win.get());
+            box(meter_win.get(), 0, 0);
+            for (int i = 0; i < METER_WIDTH; ++i) {
+                mvwaddch(meter_win.get(), 1, i + 1, '-');
+            }
+        } else {
+            needles.assign(rows, -1);
+            mvwprintw(main_win.get(), 1, 2, layout == Layout::strings ? "Str Note Frequency      Cents"
+                                                                      : "Ch  Note Frequency      Cents");
+        }
+        
+        stage(main_win.get());
+        if (layout == Layout::single) {
+            stage(meter_win.get());
+        }
+        if (stats_visible) {
+            touchwin(stats_win.get());
+            stage(stats_win.get());
+        }
+    }
+    
+public:
+    TunerDisplay() {
+        initscr();
+        start_color();
+        init_pair(1, COLOR_GREEN, COLOR_BLACK);
+        init_pair(2, COLOR_RED, COLOR_BLACK);
+        init_pair(3, COLOR_YELLOW, COLOR_BLACK);
+        
+        main_win.reset(newwin(20, 80, 0, 0));
+        meter_win.reset(newwin(3, 60, 15, 10));
+        stats_win.reset(newwin(13, 44, 1, 34));
+        
+        nodelay(main_win.get(), TRUE);
+        keypad(main_win.get(), TRUE);
+        noecho();
+        curs_set(0);
+    }
+    
+    ~TunerDisplay() {
+        endwin();
+    }
+    
+    // Shown from the next layout on, e.g. the input device in use
+    void set_title(std::string text) {
+        title = std::format(" {} ", text);
+        layout = Layout::none;
+    }
+    
+    // Non-blocking; ERR when no key is waiting
+    int poll_key() {
+        return wgetch(main_win.get());
+    }
+    
+    void update(const TunerReading& reading) {
+        set_layout(Layout::single, 5);
+        WINDOW* win = main_win.get();
+        const NoteMatch& note = reading.note;
+        const double cents_off = note.cents;
+        
+        bool changed = false;
+        changed |= put(win, 1, 2, main_lines[0], std::format("Frequency: {:.2f} Hz", reading.frequency));
+        changed |= put(win, 2, 2, main_lines[1], std::format("Note: {}{}", NoteMapper::name(note), note.octave));
+        changed |= put(win, 3, 2, main_lines[2], std::format("Target: {:.2f} Hz", note.target_hz));
+        changed |= put(win, 4, 2, main_lines[3], std::format("Cents off: {:.2f}", cents_off));
+        changed |= put(win, 5, 2, main_lines[4], std::format("Confidence: {:.0f}%", reading.confidence * 100.0));
+        if (changed) {
+            stage(win);
+        }
+        
+        // Draw meter
+        int meter_pos = 30 + static_cast<int>(cents_off / 2);
+        meter_pos = std::clamp(meter_pos, 0, METER_WIDTH - 1);
+        if (move_needle(meter_win.get(), 1, 1, needles[0], meter_pos, std::abs(cents_off) < 5 ? 1 : 3,
+                        [](int) { return '-'; })) {
+            stage(meter_win.get());
+        }
+        
+        if (stats_visible && changed) {
+            touchwin(stats_win.get());
+            stage(stats_win.get());
+        }
+    }
+    
+private:
+    // One row per channel or per string, each with its own compact meter
+    void update_rows(Layout rows_layout, std::span<const TunerReading> readings) {
+        const size_t rows = std::min(readings.size(), TunerSettings::max_channels);
+        set_layout(rows_layout, rows);
+        WINDOW* win = main_win.get();
+        
+        bool changed = false;
+        for (size_t i = 0; i < rows; ++i) {
+            const auto& reading = readings[i];
+            const int row = static_cast<int>(i) + 2;
+            
+            if (!reading.note.is_valid()) {
+                changed |= put(win, row, 2, main_lines[i], std::format("{:>2}  -", i + 1));
+                continue;
+            }
+            
+            const auto note = std::format("{}{}", NoteMapper::name(reading.note), reading.note.octave);
+            changed |= put(win, row, 2, main_lines[i], std::format("{:>2}  {:<4} {:>9.2f} Hz  {:>+6.1f}",
+                i + 1, note, reading.frequency, reading.note.cents));
+            
+            // The idle meter is drawn on the first reading, then only the needle moves
+            if (needles[i] < 0) {
+                for (int x = 0; x < CHANNEL_METER_WIDTH; ++x) {
+                    mvwaddch(win, row, CHANNEL_METER_COLUMN + x, x == 20 ? '+' : '-');
+                }
+            }
+            const int needle = 20 + std::clamp(static_cast<int>(std::lround(reading.note.cents / 2.5)), -20, 20);
+            changed |= move_needle(win, row, CHANNEL_METER_COLUMN, needles[i], needle,
+                                   std::abs(reading.note.cents) < 5 ? 1 : 3,
+                                   [](int x) { return x == 20 ? '+' : '-'; });
+        }
+        
+        if (changed) {
+            stage(win);
+            if (stats_visible) {
+                touchwin(stats_win.get());
+                stage(stats_win.get());
+            }
+        }
+    }
+    
+public:
+    void update_channels(std::span<const TunerReading> readings) {
+        update_rows(Layout::channels, readings);
+    }
+    
+    // Strum mode: row n is string n, with its cents off the open-string target
+    void update_strings(std::span<const TunerReading> readings) {
+        update_rows(Layout::strings, readings);
+    }
+    
+    void show_stats(bool visible) {
+        if (visible == stats_visible) {
+            return;
+        }
+        stats_visible = visible;
+        if (visible) {
+            stats_lines.assign(12, {});
+            werase(stats_win.get());
+            box(stats_win.get(), 0, 0);
+            mvwprintw(stats_win.get(), 0, 2, " Stats (s to hide) ");
+            stage(stats_win.get());
+        } else {
+            // Uncover whatever the pane was hiding
+            touchwin(main_win.get());
+            stage(main_win.get());
+            if (layout == Layout::single) {
+                touchwin(meter_win.get());
+                stage(meter_win.get());
+            }
+        }
+    }
+    
+    // Telemetry pane, drawn over the right-hand side of the main window
+    void update_stats(const telemetry::Stats& stats, uint64_t dropped_samples) {
+        if (!stats_visible) {
+            return;
+        }
+        WINDOW* win = stats_win.get();
+        
+        auto latency = [](std::string_view label, const telemetry::Histogram& h) {
+            return std::format("{:<10}{:>10}{:>10}{:>10}", label,
+                format_us(h.quantile(0.50)), format_us(h.quantile(0.99)), format_us(h.max()));
+        };
+        
+        const std::array<std::string, 11> lines = {
+            std::format("Callbacks {:>10}  xruns {:>8}", stats.callbacks.load(), stats.input_overflows.load()),
+            std::format("Dropped   {:>10}  gated {:>8}", dropped_samples, stats.gated.load()),
+            std::format("Onsets    {:>10}", stats.onsets.load()),
+            std::format("{:<10}{:>10}{:>10}{:>10}", "", "p50", "p99", "max"),
+            latency("Callback", stats.callback_ns),
+            std::format("{:<10}{:>9.1f}%{:>9.1f}%{:>9.1f}%", "Deadline",
+                stats.deadline_permille.quantile(0.50) / 10.0, stats.deadline_permille.quantile(0.99) / 10.0,
+                stats.deadline_permille.max() / 10.0),
+            std::format("{:<10}{:>10}{:>10}{:>10}", "Queue",
+                stats.queue_depth.quantile(0.50), stats.queue_depth.quantile(0.99), stats.queue_depth.max()),
+            latency("Detector", stats.detector_ns),
+            latency("Detection", stats.detection_ns),
+            latency("Render", stats.render_ns),
+            std::format("{:<10}{:>10}", "In lat p50", format_us(stats.input_latency_us.quantile(0.50) * 1000)),
+        };
+        
+        bool changed = false;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            changed |= put(win, static_cast<int>(i) + 1, 2, stats_lines[i], lines[i]);
+        }
+        if (changed) {
+            stage(win);
+        }
+    }
+    
+    // Sends every staged window to the terminal in one update; returns false if
+    // nothing had changed
+    bool present() {
+        if (!staged) {
+            return false;
+        }
+        doupdate();
+        staged = false;
+        return true;
+    }
+};
+
+// Draws the results a daemon publishes, on any terminal of the same machine. A frame
+// is a few plain loads from the mapping, so any number of these can run without the
+// daemon noticing.
+inline Result<void> attach_display(const TunerSettings& settings) {
+    // A writer that was killed leaves its segment behind without a heartbeat
+    static constexpr uint64_t STALE_NS = 2'000'000'000;
+    
+    auto view = SharedResultsView::open(settings.attach);
+    if (!view) {
+        return std::unexpected(view.error());
+    }
+    EventLoop events(true);
+    if (!events.is_valid()) {
+        return std::unexpected(TunerError(std::format("Cannot create the event loop: {}", std::strerror(errno))));
+    }
+    
+    TunerDisplay display;
+    display.set_title(std::format("{} (attached) {:g} Hz", shared_detail::segment_path(settings.attach),
+                                  view->sample_rate()));
+    const size_t rows = view->rows();
+    std::vector<uint64_t> rendered_versions(rows, 0);
+    std::vector<TunerReading> readings(rows);
+    // The segment is polled once a frame; keys and signals wake the loop at once
+    const int frame_ms = static_cast<int>(std::max<size_t>(1000 / settings.max_fps, 1));
+    while (view->live()) {
+        const EventLoop::Events ready = events.wait(frame_ms);
+        if (ready.signal) {
+            return {};
+        }
+        for (int ch = ready.input ? display.poll_key() : ERR; ch != ERR; ch = display.poll_key()) {
+            if (ch == 'q' || ch == 'Q') {
+                return {};
+            }
+        }
+        if (const uint64_t beat = view->heartbeat_ns(); beat && telemetry::now_ns() - beat > STALE_NS) {
+            return std::unexpected(TunerError("The daemon stopped updating"));
+        }
+        
+        bool changed = false;
+        for (size_t r = 0; r < rows; ++r) {
+            if (auto version = view->version(r); version != rendered_versions[r]) {
+                rendered_versions[r] = version;
+                readings[r] = TunerReading::from_shared(view->load(r));
+                changed = true;
+            }
+        }
+        if (changed) {
+            if (view->layout() == SharedLayout::strings) {
+                display.update_strings(readings);
+            } else if (rows == 1) {
+                display.update(readings[0]);
+            } else {
+                display.update_channels(readings);
+            }
+        }
+        display.present();
+    }
+    return std::unexpected(TunerError("The daemon has shut down"));
+}
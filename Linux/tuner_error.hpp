@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <memory>
+#include <source_location>
+#include <string>
+#include <string_view>
+
+// Error handling with std::expected.
+// A string literal is referenced rather than copied, so the routine failures of the
+// analysis path (no pitch in this frame) cost no allocation; built messages are
+// shared between copies of the error.
+struct TunerError {
+private:
+    std::shared_ptr<const std::string> owned;
+    
+public:
+    std::string_view message;
+    std::source_location location;
+    
+    template<size_t N>
+    TunerError(const char (&literal)[N], const std::source_location& loc = std::source_location::current())
+        : message(literal, N - 1), location(loc) {}
+    
+    TunerError(std::string msg, const std::source_location& loc = std::source_location::current())
+        : owned(std::make_shared<const std::string>(std::move(msg))), message(*owned), location(loc) {}
+};
+
+template<typename T>
+using Result = std::expected<T, TunerError>;
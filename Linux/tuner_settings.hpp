@@ -0,0 +1,317 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include "note_mapping.hpp"
+#include "pcm_input.hpp"
+#include "pitch_detectors.hpp"
+#include "realtime.hpp"
+#include "spectral_peak.hpp"
+#include "tuner_error.hpp"
+#include "tunings.hpp"
+#include "window_functions.hpp"
+
+// Analysis precision. Single precision (fftwf_*, link -lfftw3f) keeps the paFloat32
+// samples as float end to end; build with -DTUNER_DOUBLE_PRECISION (link -lfftw3)
+// for measurement-grade double.
+#ifdef TUNER_DOUBLE_PRECISION
+using Sample = double;
+#else
+using Sample = float;
+#endif
+
+// Modern tuning configuration with modules (requires C++23 modules support)
+struct TuningConfig {
+    struct Note {
+        std::string name;
+        double frequency;
+        
+        constexpr auto operator<=>(const Note&) const = default;
+    };
+    
+    // Guitar, 7 and 8-string, bass and ukulele presets, generated at compile time
+    static constexpr const auto& tuning_presets = tunings::catalogue;
+    
+    static constexpr auto note_names = NoteMapper::note_names;
+    
+    // Case-insensitive, with '-' for spaces: "standard", "drop-d", "7-string", "bass"
+    static std::optional<size_t> find_preset(std::string_view name) {
+        return tunings::find(name);
+    }
+    
+    static std::span<const double> strings(size_t preset, tunings::Temperament temperament) {
+        return tuning_presets[preset].frequencies(temperament);
+    }
+};
+
+// Device buffer, analysis window and hop are independent: the window sets the
+// frequency resolution, the hop sets the update latency (hop / sample_rate)
+struct TunerSettings {
+    static constexpr size_t max_channels = 16;  // one display row each
+    
+    size_t buffer_size = 256;   // frames per PortAudio callback
+    size_t window_size = 4096;  // samples per FFT
+    size_t hop_size = 512;      // new samples between consecutive analyses
+    size_t channels = 1;        // input channels, each tuned independently
+    size_t workers = 0;         // analysis threads; 0 = one per core, at most one per channel
+    double a4_hz = NoteMapper::default_a4_hz;
+    DetectorKind detector = DetectorKind::fft;
+    WindowType window = WindowType::hann;
+    SpectralPeakOptions peak;   // FFT detector only
+    
+    // Adaptive window: the analysis window shrinks, in halves down to an eighth, to the
+    // shortest one whose resolution at the tracked note is within this many cents.
+    // window_size is the largest; 0 keeps it fixed.
+    double adaptive_cents = 0.0;
+    
+    // Locked-string mode: the detector only acquires a string of the preset, which
+    // narrowband tracking then follows
+    std::optional<size_t> lock_preset;  // index into TuningConfig::tuning_presets
+    size_t lock_string = 0;             // 1 (the highest string) up; 0 = nearest string
+    
+    // Strum mode: all strings of the preset measured at once, one row per string
+    std::optional<size_t> strum_preset;
+    
+    // Open-string targets of the lock and strum presets
+    tunings::Temperament temperament = tunings::Temperament::equal;
+    
+    // Capture device and rate. The window and hop count samples at the analysis rate,
+    // the opened rate divided by the decimation factor.
+    std::string device;         // index or part of the name; empty = preferred default input
+    double sample_rate = 0.0;   // 0 = the device's default, or default_raw_rate for raw input
+    double latency_ms = 0.0;    // suggested input latency; 0 = the device's lowest
+    size_t decimation = 1;      // 1, 2, 4 or 8
+    static constexpr double default_raw_rate = 44100.0;
+    
+    // Offline mode: WAV/raw files, directories of them, or "-" for stdin
+    std::vector<std::string> offline_inputs;
+    std::optional<PcmEncoding> raw_encoding;    // headerless input; uses channels and sample_rate
+    
+    // Live telemetry dump: one JSON line per interval, appended to stats_file
+    std::string stats_file;
+    size_t stats_interval_ms = 1000;
+    
+    // Display refresh cap; results published between two frames are not drawn
+    size_t max_fps = 30;
+    
+    // Headless operation: no terminal UI, results go to shared memory and to OSC.
+    // Both also work alongside the display; --attach draws a running daemon's results.
+    bool daemon = false;
+    std::string shm_name;       // shared-memory segment; --daemon defaults to default_shm_name
+    std::string osc_target;     // host:port; empty = no OSC
+    size_t osc_rate = 10;       // OSC updates per second per row, at most
+    std::string attach;         // segment to display instead of capturing
+    static constexpr std::string_view default_shm_name = "guitar-tuner";
+    
+    // --realtime: SCHED_FIFO, CPU pinning and locked memory for the callback and workers
+    realtime::Options realtime;
+    
+    static Result<TunerSettings> from_args(std::span<char*> args) {
+        using namespace std::literals;
+        TunerSettings settings;
+        
+        auto parse = [](std::string_view arg, std::string_view value, auto& target) -> Result<void> {
+            if (auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), target);
+                ec != std::errc{} || end != value.data() + value.size()) {
+                return std::unexpected(TunerError(std::format("Invalid value for {}: {}", arg, value)));
+            }
+            return {};
+        };
+        
+        // Options taking a value that is not a plain number
+        static constexpr std::array text_options = {
+            "--detector"sv, "--window"sv, "--peak"sv, "--lock"sv, "--strum"sv, "--temperament"sv, "--analyze"sv,
+            "--raw"sv, "--stats-file"sv, "--device"sv, "--shm"sv, "--osc"sv, "--attach"sv, "--rt-priority"sv,
+            "--audio-cpus"sv, "--analysis-cpus"sv,
+        };
+        
+        for (size_t i = 0; i < args.size(); ++i) {
+            std::string_view arg = args[i];
+            if (arg == "--daemon"sv || arg == "--realtime"sv) {
+                (arg == "--daemon"sv ? settings.daemon : settings.realtime.enabled) = true;
+                continue;
+            }
+            size_t* target = arg == "--buffer-size"sv ? &settings.buffer_size
+                           : arg == "--window-size"sv ? &settings.window_size
+                           : arg == "--hop-size"sv    ? &settings.hop_size
+                           : arg == "--channels"sv    ? &settings.channels
+                           : arg == "--workers"sv     ? &settings.workers
+                           : arg == "--stats-interval"sv ? &settings.stats_interval_ms
+                           : arg == "--fps"sv         ? &settings.max_fps
+                           : arg == "--zero-pad"sv    ? &settings.peak.zero_padding
+                           : arg == "--string"sv      ? &settings.lock_string
+                           : arg == "--decimate"sv    ? &settings.decimation
+                           : arg == "--osc-rate"sv    ? &settings.osc_rate
+                           : nullptr;
+            double* real_target = arg == "--a4"sv      ? &settings.a4_hz
+                                : arg == "--adaptive-window"sv ? &settings.adaptive_cents
+                                : arg == "--rate"sv    ? &settings.sample_rate
+                                : arg == "--latency"sv ? &settings.latency_ms
+                                : nullptr;
+            if (!target && !real_target && std::ranges::find(text_options, arg) == text_options.end()) {
+                return std::unexpected(TunerError(std::format("Unknown option: {}", arg)));
+            }
+            if (i + 1 == args.size()) {
+                return std::unexpected(TunerError(std::format("Missing value for {}", arg)));
+            }
+            std::string_view value = args[++i];
+            if (arg == "--detector"sv) {
+                auto kind = parse_detector_kind(value);
+                if (!kind) {
+                    return std::unexpected(kind.error());
+                }
+                settings.detector = *kind;
+                continue;
+            }
+            if (arg == "--window"sv) {
+                auto type = parse_window_type(value);
+                if (!type) {
+                    return std::unexpected(TunerError(std::format("Unknown window function: {}", value)));
+                }
+                settings.window = *type;
+                continue;
+            }
+            if (arg == "--peak"sv) {
+                auto picking = parse_peak_picking(value);
+                if (!picking) {
+                    return std::unexpected(picking.error());
+                }
+                settings.peak.picking = *picking;
+                continue;
+            }
+            if (arg == "--lock"sv || arg == "--strum"sv) {
+                auto& preset = arg == "--lock"sv ? settings.lock_preset : settings.strum_preset;
+                preset = TuningConfig::find_preset(value);
+                if (!preset) {
+                    return std::unexpected(TunerError(std::format("Unknown tuning preset: {}", value)));
+                }
+                continue;
+            }
+            if (arg == "--temperament"sv) {
+                auto temperament = tunings::find_temperament(value);
+                if (!temperament) {
+                    return std::unexpected(TunerError(std::format("Unknown temperament: {}", value)));
+                }
+                settings.temperament = *temperament;
+                continue;
+            }
+            if (arg == "--analyze"sv) {
+                settings.offline_inputs.emplace_back(value);
+                continue;
+            }
+            if (arg == "--stats-file"sv) {
+                settings.stats_file = value;
+                continue;
+            }
+            if (arg == "--device"sv) {
+                settings.device = value;
+                continue;
+            }
+            if (arg == "--rt-priority"sv) {
+                if (auto parsed = parse(arg, value, settings.realtime.priority); !parsed) {
+                    return std::unexpected(parsed.error());
+                }
+                continue;
+            }
+            if (arg == "--audio-cpus"sv || arg == "--analysis-cpus"sv) {
+                auto& cpus = arg == "--audio-cpus"sv ? settings.realtime.audio_cpus : settings.realtime.analysis_cpus;
+                cpus = realtime::parse_cpus(value);
+                if (cpus.empty()) {
+                    return std::unexpected(TunerError(std::format("Invalid CPU list for {}: {}", arg, value)));
+                }
+                continue;
+            }
+            if (arg == "--shm"sv || arg == "--osc"sv || arg == "--attach"sv) {
+                (arg == "--shm"sv ? settings.shm_name : arg == "--osc"sv ? settings.osc_target : settings.attach) = value;
+                continue;
+            }
+            if (arg == "--raw"sv) {
+                auto encoding = parse_pcm_encoding(value);
+                if (!encoding) {
+                    return std::unexpected(encoding.error());
+                }
+                settings.raw_encoding = *encoding;
+                continue;
+            }
+            if (auto parsed = target ? parse(arg, value, *target) : parse(arg, value, *real_target); !parsed) {
+                return std::unexpected(parsed.error());
+            }
+        }
+        
+        if (settings.buffer_size == 0 || settings.window_size < 2) {
+            return std::unexpected(TunerError("Buffer and window sizes must be positive"));
+        }
+        if (settings.hop_size == 0 || settings.hop_size > settings.window_size) {
+            return std::unexpected(TunerError("Hop size must be between 1 and the window size"));
+        }
+        if (settings.peak.zero_padding != 1 && settings.peak.zero_padding != 2 && settings.peak.zero_padding != 4) {
+            return std::unexpected(TunerError("Zero padding must be 1, 2 or 4"));
+        }
+        if (settings.lock_string && !settings.lock_preset) {
+            return std::unexpected(TunerError("--string needs a --lock preset"));
+        }
+        if (settings.lock_preset && settings.lock_string > TuningConfig::tuning_presets[*settings.lock_preset].strings) {
+            return std::unexpected(TunerError(std::format("--string takes 1 to {} for this preset",
+                TuningConfig::tuning_presets[*settings.lock_preset].strings)));
+        }
+        if (settings.strum_preset && settings.lock_preset) {
+            return std::unexpected(TunerError("--strum and --lock cannot be combined"));
+        }
+        if (settings.adaptive_cents > 0.0 && (settings.lock_preset || settings.strum_preset)) {
+            return std::unexpected(TunerError("--adaptive-window cannot be combined with --lock or --strum"));
+        }
+        if (settings.strum_preset && settings.channels > 1 && settings.offline_inputs.empty()) {
+            return std::unexpected(TunerError("The live strum display shows a single channel"));
+        }
+        if (settings.lock_preset && settings.hop_size + 4 >= settings.window_size) {
+            return std::unexpected(TunerError("Locked-string mode needs a hop shorter than the window"));
+        }
+        if (!(settings.a4_hz > 0.0)) {
+            return std::unexpected(TunerError("A4 reference must be a positive frequency"));
+        }
+        if (settings.stats_interval_ms == 0) {
+            return std::unexpected(TunerError("Stats interval must be positive"));
+        }
+        if (settings.max_fps == 0) {
+            return std::unexpected(TunerError("Frame rate must be positive"));
+        }
+        if (!(settings.sample_rate >= 0.0) || !(settings.latency_ms >= 0.0)) {
+            return std::unexpected(TunerError("Sample rate and latency must not be negative"));
+        }
+        if (!(settings.adaptive_cents >= 0.0)) {
+            return std::unexpected(TunerError("Adaptive window resolution must not be negative"));
+        }
+        if (settings.decimation != 1 && settings.decimation != 2 && settings.decimation != 4 && settings.decimation != 8) {
+            return std::unexpected(TunerError("Decimation must be 1, 2, 4 or 8"));
+        }
+        if (settings.channels == 0 || settings.channels > max_channels) {
+            return std::unexpected(TunerError(std::format("Channel count must be between 1 and {}", max_channels)));
+        }
+        if (settings.realtime.priority < 1 || settings.realtime.priority > 98) {
+            return std::unexpected(TunerError("Real-time priority must be between 1 and 98"));
+        }
+        if (settings.osc_rate == 0) {
+            return std::unexpected(TunerError("OSC rate must be positive"));
+        }
+#ifdef TUNER_HEADLESS
+        // Built without the display: live capture always runs as a daemon
+        if (!settings.attach.empty()) {
+            return std::unexpected(TunerError("--attach needs a build with the display"));
+        }
+        settings.daemon = true;
+#endif
+        if (settings.daemon && settings.shm_name.empty()) {
+            settings.shm_name = default_shm_name;
+        }
+        return settings;
+    }
+};
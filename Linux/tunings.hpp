@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+// Instrument tunings and note frequency tables, generated at compile time.
+// Presets are written as note names and expanded by constexpr code into every
+// temperament's open-string frequencies, so the tables are read-only data: nothing is
+// built at startup and no pow/exp2 runs to look a note up. Frequencies are referenced
+// to A4 = 440 Hz; strings are listed from string 1, the highest, down.
+namespace tunings {
+
+enum class Temperament { equal, just, sweetened };
+
+inline constexpr std::array<std::string_view, 3> temperament_names = { "equal", "just", "sweetened" };
+
+inline constexpr size_t max_strings = 8;
+
+namespace detail {
+
+// 2^x for constant evaluation (std::exp2 is not constexpr before C++26): the integer
+// part scales by powers of two, the fraction goes through e^(f ln 2) as a Taylor
+// series, which converges to double precision in 20 terms for f ln 2 < 0.7
+constexpr double exp2(double x) {
+    int whole = static_cast<int>(x);
+    if (x < whole) {
+        --whole;
+    }
+    const double y = (x - whole) * 0.69314718055994530942;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int k = 1; k <= 20; ++k) {
+        term *= y / k;
+        sum += term;
+    }
+    for (; whole > 0; --whole) {
+        sum *= 2.0;
+    }
+    for (; whole < 0; ++whole) {
+        sum *= 0.5;
+    }
+    return sum;
+}
+
+// MIDI number of a note name such as "E2", "C#3" or "Bb1" (C4 = 60). An invalid
+// name in a preset is a compile error, as the throw cannot be constant-evaluated.
+constexpr int midi_of(std::string_view note) {
+    constexpr std::array<int, 7> letters = { 9, 11, 0, 2, 4, 5, 7 };   // A to G
+    if (note.size() < 2 || note[0] < 'A' || note[0] > 'G') {
+        throw "invalid note name";
+    }
+    int pitch = letters[note[0] - 'A'];
+    size_t i = 1;
+    if (note[i] == '#') {
+        ++pitch;
+        ++i;
+    } else if (note[i] == 'b') {
+        --pitch;
+        ++i;
+    }
+    if (i + 1 != note.size() || note[i] < '0' || note[i] > '9') {
+        throw "invalid note name";
+    }
+    return (note[i] - '0' + 1) * 12 + pitch;
+}
+
+} // namespace detail
+
+constexpr double equal_hz(int midi) {
+    return 440.0 * detail::exp2((midi - 69) / 12.0);
+}
+
+// Equal-temperament frequency of every MIDI note at A4 = 440 Hz
+inline constexpr auto equal_temperament = [] {
+    std::array<double, 128> table{};
+    for (int midi = 0; midi < 128; ++midi) {
+        table[midi] = equal_hz(midi);
+    }
+    return table;
+}();
+
+// 5-limit just intervals above the tonic, per semitone
+inline constexpr std::array<std::pair<int, int>, 12> just_ratios = {{
+    {1, 1}, {16, 15}, {9, 8}, {6, 5}, {5, 4}, {4, 3}, {45, 32}, {3, 2}, {8, 5}, {5, 3}, {16, 9}, {15, 8}
+}};
+
+template<size_t Strings>
+struct Preset {
+    std::string_view name;
+    std::array<std::string_view, Strings> notes;    // string 1 first
+};
+
+// One type per instrument, so lookups can specialize on the string count. sweetened
+// holds per-string offsets in cents from equal temperament, in the manner of the
+// Feiten system; instruments without an established set are left at zero.
+struct Guitar {
+    static constexpr size_t strings = 6;
+    static constexpr std::array<double, strings> sweetened = { -2.0, -1.5, -3.0, -2.0, 0.0, -2.0 };
+    static constexpr std::array presets = {
+        Preset<strings>{"Standard", {"E4", "B3", "G3", "D3", "A2", "E2"}},
+        Preset<strings>{"Drop D", {"E4", "B3", "G3", "D3", "A2", "D2"}},
+        Preset<strings>{"Open G", {"D4", "B3", "G3", "D3", "G2", "D2"}},
+        Preset<strings>{"DADGAD", {"D4", "A3", "G3", "D3", "A2", "D2"}},
+        Preset<strings>{"Open D", {"D4", "A3", "F#3", "D3", "A2", "D2"}},
+        Preset<strings>{"Half Step Down", {"Eb4", "Bb3", "Gb3", "Db3", "Ab2", "Eb2"}},
+        Preset<strings>{"Drop C", {"D4", "A3", "F3", "C3", "G2", "C2"}}
+    };
+};
+
+// The extended low strings are left at equal temperament
+struct SevenString {
+    static constexpr size_t strings = 7;
+    static constexpr std::array<double, strings> sweetened = { -2.0, -1.5, -3.0, -2.0, 0.0, -2.0, 0.0 };
+    static constexpr std::array presets = {
+        Preset<strings>{"7 String", {"E4", "B3", "G3", "D3", "A2", "E2", "B1"}},
+        Preset<strings>{"7 String Drop A", {"E4", "B3", "G3", "D3", "A2", "E2", "A1"}}
+    };
+};
+
+struct EightString {
+    static constexpr size_t strings = 8;
+    static constexpr std::array<double, strings> sweetened = { -2.0, -1.5, -3.0, -2.0, 0.0, -2.0, 0.0, 0.0 };
+    static constexpr std::array presets = {
+        Preset<strings>{"8 String", {"E4", "B3", "G3", "D3", "A2", "E2", "B1", "F#1"}},
+        Preset<strings>{"8 String Drop E", {"E4", "B3", "G3", "D3", "A2", "E2", "B1", "E1"}}
+    };
+};
+
+struct Bass {
+    static constexpr size_t strings = 4;
+    static constexpr std::array<double, strings> sweetened{};
+    static constexpr std::array presets = {
+        Preset<strings>{"Bass", {"G2", "D2", "A1", "E1"}},
+        Preset<strings>{"Bass Drop D", {"G2", "D2", "A1", "D1"}}
+    };
+};
+
+// Standard ukulele tuning is re-entrant: string 4 is above strings 3 and 2
+struct Ukulele {
+    static constexpr size_t strings = 4;
+    static constexpr std::array<double, strings> sweetened{};
+    static constexpr std::array presets = {
+        Preset<strings>{"Ukulele", {"A4", "E4", "C4", "G4"}},
+        Preset<strings>{"Baritone Ukulele", {"E4", "B3", "G3", "D3"}}
+    };
+};
+
+// Open-string frequencies of a preset. Just intonation is taken relative to the
+// lowest string, the root of most open and drop tunings.
+template<typename Instrument>
+constexpr std::array<double, Instrument::strings> frequencies(const Preset<Instrument::strings>& preset,
+                                                              Temperament temperament) {
+    std::array<int, Instrument::strings> midi{};
+    for (size_t s = 0; s < midi.size(); ++s) {
+        midi[s] = detail::midi_of(preset.notes[s]);
+    }
+    const int tonic = *std::min_element(midi.begin(), midi.end());
+
+    std::array<double, Instrument::strings> hz{};
+    for (size_t s = 0; s < hz.size(); ++s) {
+        switch (temperament) {
+        case Temperament::equal:
+            hz[s] = equal_hz(midi[s]);
+            break;
+        case Temperament::just: {
+            const int interval = midi[s] - tonic;
+            const auto [numerator, denominator] = just_ratios[interval % 12];
+            hz[s] = equal_hz(tonic) * numerator / denominator * (1 << (interval / 12));
+            break;
+        }
+        case Temperament::sweetened:
+            hz[s] = equal_hz(midi[s]) * detail::exp2(Instrument::sweetened[s] / 1200.0);
+            break;
+        }
+    }
+    return hz;
+}
+
+// Compile-time lookup for one preset of one instrument. The nearest string is found
+// by comparing against the geometric midpoints between adjacent pitches, so a lookup
+// is Strings - 1 comparisons with no logarithm.
+template<typename Instrument, size_t PresetIndex = 0, Temperament Temper = Temperament::equal>
+struct Strings {
+    static constexpr const auto& preset = Instrument::presets[PresetIndex];
+    static constexpr auto hz = frequencies<Instrument>(preset, Temper);
+
+private:
+    // String indices by ascending pitch, and the boundaries between neighbours
+    static constexpr auto order = [] {
+        std::array<size_t, Instrument::strings> index{};
+        for (size_t s = 0; s < index.size(); ++s) {
+            index[s] = s;
+        }
+        std::sort(index.begin(), index.end(), [](size_t a, size_t b) { return hz[a] < hz[b]; });
+        return index;
+    }();
+
+    static constexpr auto bounds = [] {
+        std::array<double, Instrument::strings - 1> mid{};
+        for (size_t i = 0; i < mid.size(); ++i) {
+            // sqrt(lo * hi) by Newton's method, converged long before the last iteration
+            const double lo = hz[order[i]];
+            const double hi = hz[order[i + 1]];
+            double root = hi;
+            for (int k = 0; k < 60; ++k) {
+                root = 0.5 * (root + lo * hi / root);
+            }
+            mid[i] = root;
+        }
+        return mid;
+    }();
+
+public:
+    // Index of the string closest in cents to frequency (at A4 = 440 Hz)
+    static constexpr size_t nearest(double frequency) noexcept {
+        size_t i = 0;
+        while (i < bounds.size() && frequency >= bounds[i]) {
+            ++i;
+        }
+        return order[i];
+    }
+};
+
+// Every preset of every instrument, with its open strings in each temperament, for
+// selection by name at runtime
+struct Entry {
+    std::string_view name;
+    size_t strings = 0;
+    std::array<std::array<double, max_strings>, temperament_names.size()> hz{};
+
+    constexpr std::span<const double> frequencies(Temperament temperament) const {
+        return std::span<const double>(hz[static_cast<size_t>(temperament)]).first(strings);
+    }
+};
+
+namespace detail {
+
+template<typename... Instruments>
+constexpr auto make_catalogue() {
+    std::array<Entry, (Instruments::presets.size() + ...)> entries{};
+    size_t next = 0;
+    auto add = [&]<typename Instrument>(Instrument*) {
+        static_assert(Instrument::strings <= max_strings);
+        for (const auto& preset : Instrument::presets) {
+            Entry& entry = entries[next++];
+            entry.name = preset.name;
+            entry.strings = Instrument::strings;
+            for (size_t t = 0; t < temperament_names.size(); ++t) {
+                const auto hz = tunings::frequencies<Instrument>(preset, static_cast<Temperament>(t));
+                std::copy(hz.begin(), hz.end(), entry.hz[t].begin());
+            }
+        }
+    };
+    (add(static_cast<Instruments*>(nullptr)), ...);
+    return entries;
+}
+
+} // namespace detail
+
+inline constexpr auto catalogue = detail::make_catalogue<Guitar, SevenString, EightString, Bass, Ukulele>();
+
+// Case-insensitive, with '-' for spaces: "standard", "drop-d", "7-string", "bass-drop-d"
+constexpr std::optional<size_t> find(std::string_view name) {
+    auto fold = [](char c) {
+        return c == ' ' ? '-' : c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    };
+    for (size_t i = 0; i < catalogue.size(); ++i) {
+        if (std::ranges::equal(catalogue[i].name, name, {}, fold, fold)) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+constexpr std::optional<Temperament> find_temperament(std::string_view name) {
+    for (size_t i = 0; i < temperament_names.size(); ++i) {
+        if (temperament_names[i] == name) {
+            return static_cast<Temperament>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace tunings
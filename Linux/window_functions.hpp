@@ -0,0 +1,200 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include "arena.hpp"
+#include "fft_wisdom.hpp"
+
+// Analysis window functions, trading frequency resolution against leakage:
+//   hann            - narrow main lobe, -31 dB sidelobes; the default
+//   blackman-harris - 4-term, -92 dB sidelobes; keeps weak partials out of the peak search
+//   flat-top        - < 0.01 dB scalloping; accurate peak amplitude, wide main lobe
+enum class WindowType { hann, blackman_harris, flat_top };
+
+// Also used by the C++20 tuner.cpp, so unknown names are reported as std::nullopt
+inline std::optional<WindowType> parse_window_type(std::string_view name) {
+    if (name == "hann") return WindowType::hann;
+    if (name == "blackman-harris") return WindowType::blackman_harris;
+    if (name == "flat-top") return WindowType::flat_top;
+    return std::nullopt;
+}
+
+constexpr std::string_view window_name(WindowType type) {
+    switch (type) {
+        case WindowType::blackman_harris: return "blackman-harris";
+        case WindowType::flat_top: return "flat-top";
+        case WindowType::hann: break;
+    }
+    return "hann";
+}
+
+// Half width of the main lobe in bins: peaks closer than this merge
+constexpr size_t main_lobe_bins(WindowType type) {
+    switch (type) {
+        case WindowType::blackman_harris: return 4;
+        case WindowType::flat_top: return 5;
+        case WindowType::hann: break;
+    }
+    return 2;
+}
+
+namespace window_detail {
+
+// std::cos is not constexpr before C++26. Reduced to [0, pi/2], the Taylor series
+// below is accurate to double rounding, which is all the tables need.
+constexpr double cos(double x) {
+    constexpr double pi = std::numbers::pi;
+    x -= 2.0 * pi * static_cast<long long>(x / (2.0 * pi));
+    if (x < 0.0) x = -x;
+    if (x > pi) x = 2.0 * pi - x;
+
+    double sign = 1.0;
+    if (x > pi / 2) {
+        x = pi - x;
+        sign = -1.0;
+    }
+
+    const double x2 = x * x;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int k = 1; k <= 12; ++k) {
+        term *= -x2 / ((2 * k - 1) * (2 * k));
+        sum += term;
+    }
+    return sign * sum;
+}
+
+// Generalized cosine window: w[i] = sum_k (-1)^k a_k cos(2 pi k i / (n - 1))
+constexpr std::array<double, 5> cosine_terms(WindowType type) {
+    switch (type) {
+        case WindowType::blackman_harris: return {0.35875, 0.48829, 0.14128, 0.01168, 0.0};
+        case WindowType::flat_top: return {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368};
+        case WindowType::hann: break;
+    }
+    return {0.5, 0.5, 0.0, 0.0, 0.0};
+}
+
+// Evaluates the window given c1 = cos(2 pi i / (n - 1)); the higher harmonics come from
+// the Chebyshev recurrence cos(k t) = 2 cos(t) cos((k-1) t) - cos((k-2) t)
+constexpr double cosine_sum(WindowType type, double c1) {
+    const auto a = cosine_terms(type);
+    double previous = 1.0;
+    double current = c1;
+    double w = a[0] - a[1] * c1;
+    double sign = 1.0;
+    for (size_t k = 2; k < a.size() && a[k] != 0.0; ++k) {
+        const double next = 2.0 * c1 * current - previous;
+        previous = current;
+        current = next;
+        w += sign * a[k] * current;
+        sign = -sign;
+    }
+    return w;
+}
+
+constexpr double coefficient(WindowType type, size_t i, size_t n) {
+    if (n < 2) {
+        return 1.0;
+    }
+    return cosine_sum(type, cos(2.0 * std::numbers::pi * static_cast<double>(i) / static_cast<double>(n - 1)));
+}
+
+// The windows are symmetric, so only the first half is evaluated. Between exact cos()
+// seeds every 64 samples the base angle is advanced by rotation, which keeps the
+// compile-time cost of the larger tables down without a measurable loss of accuracy.
+template<typename Real, WindowType Type, size_t N>
+constexpr std::array<Real, N> make_table() {
+    constexpr double pi = std::numbers::pi;
+    constexpr double step = N > 1 ? 2.0 * pi / static_cast<double>(N - 1) : 0.0;
+    constexpr double cos_step = cos(step);
+    constexpr double sin_step = cos(pi / 2 - step);
+
+    std::array<Real, N> table{};
+    double c = 1.0;
+    double s = 0.0;
+    for (size_t i = 0; i < (N + 1) / 2; ++i) {
+        if (i % 64 == 0) {
+            c = cos(step * static_cast<double>(i));
+            s = cos(pi / 2 - step * static_cast<double>(i));
+        }
+        table[i] = table[N - 1 - i] = static_cast<Real>(N > 1 ? cosine_sum(Type, c) : 1.0);
+        const double next_c = c * cos_step - s * sin_step;
+        s = s * cos_step + c * sin_step;
+        c = next_c;
+    }
+    return table;
+}
+
+// One table per supported window size up to the default analysis windows, evaluated at
+// compile time into read-only data. Larger sizes are rare and cost seconds of compile
+// time each, so they are computed at startup instead.
+inline constexpr size_t max_table_size = 4096;
+
+template<typename Real, WindowType Type, size_t N>
+alignas(64) inline constexpr std::array<Real, N> table = make_table<Real, Type, N>();
+
+template<typename Real, WindowType Type, size_t N>
+const Real* table_for(size_t size) {
+    if constexpr (N <= max_table_size) {
+        return size == N ? table<Real, Type, N>.data() : nullptr;
+    } else {
+        return nullptr;
+    }
+}
+
+template<typename Real, WindowType Type, size_t... I>
+const Real* find_table(size_t size, std::index_sequence<I...>) {
+    const Real* found = nullptr;
+    ((found = found ? found : table_for<Real, Type, fft_wisdom::supported_window_sizes[I]>(size)), ...);
+    return found;
+}
+
+template<typename Real, WindowType Type>
+const Real* find_table(size_t size) {
+    return find_table<Real, Type>(size, std::make_index_sequence<fft_wisdom::supported_window_sizes.size()>{});
+}
+
+} // namespace window_detail
+
+// Read-only window coefficients, kept apart from any FFT buffer.
+// Sizes with a compile-time table point straight at it; any other size is computed
+// once into a cache-line-aligned buffer from the given memory resource.
+template<typename Real = double>
+class WindowTable {
+    WindowType window_type;
+    size_t length;
+    AlignedBuffer<Real> computed{0};
+    const Real* values = nullptr;
+
+public:
+    WindowTable(WindowType type, size_t size, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : window_type(type), length(size) {
+        switch (type) {
+            case WindowType::hann: values = window_detail::find_table<Real, WindowType::hann>(size); break;
+            case WindowType::blackman_harris: values = window_detail::find_table<Real, WindowType::blackman_harris>(size); break;
+            case WindowType::flat_top: values = window_detail::find_table<Real, WindowType::flat_top>(size); break;
+        }
+        if (values || size == 0) {
+            return;
+        }
+
+        computed = AlignedBuffer<Real>(size, memory);
+        for (size_t i = 0; i < size; ++i) {
+            computed[i] = static_cast<Real>(window_detail::coefficient(type, i, size));
+        }
+        values = computed.get();
+    }
+
+    WindowType type() const noexcept { return window_type; }
+    size_t size() const noexcept { return length; }
+
+    std::span<const Real> coefficients() const noexcept {
+        return std::span<const Real>(values, length);
+    }
+};
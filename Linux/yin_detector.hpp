@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <memory_resource>
+#include <vector>
+#include "correlation.hpp"
+#include "pitch_detector.hpp"
+
+// YIN pitch detector (de Cheveigne & Kawahara, 2002).
+// The difference function d(tau) = e(0) + e(tau) - 2 r(tau) is built from an
+// FFT cross-correlation of the first half of the frame against the whole frame,
+// then normalized by its cumulative mean. Lags up to half the frame are usable,
+// so a 2048-sample frame at 44.1 kHz still resolves the low E string.
+// Energies and the normalized difference are accumulated in double at either precision.
+template<typename Real = double>
+class YinDetector : public PitchDetector<Real> {
+    size_t window_size;
+    size_t integration_size;
+    double sample_rate;
+    double threshold;
+    size_t min_lag;
+    size_t max_lag;
+    Correlator<Real> correlator;
+    std::pmr::vector<Real> correlation;
+    std::pmr::vector<double> energy;        // prefix sums of x^2
+    std::pmr::vector<double> difference;    // cumulative-mean-normalized difference
+    
+public:
+    static constexpr double unvoiced_limit = 0.5;
+    
+    YinDetector(size_t size, double rate, double yin_threshold = 0.12,
+                double min_frequency = 60.0, double max_frequency = 1500.0,
+                std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        window_size(size),
+        integration_size(size / 2),
+        sample_rate(rate),
+        threshold(yin_threshold),
+        min_lag(std::max<size_t>(2, static_cast<size_t>(rate / max_frequency))),
+        max_lag(std::min(size / 2 - 2, static_cast<size_t>(std::ceil(rate / min_frequency)))),
+        correlator(size, memory),
+        correlation(size / 2 + 1, memory),
+        energy(size + 1, memory),
+        difference(size / 2 + 1, memory) {}
+    
+    std::string_view name() const override { return "yin"; }
+    
+    size_t size() const override { return window_size; }
+    
+    Result<double> analyze(std::span<const Real> audio_data) override {
+        if (audio_data.size() != window_size) {
+            return std::unexpected(TunerError("Invalid audio buffer size"));
+        }
+        
+        const size_t w = integration_size;
+        correlator.cross_correlate(audio_data.first(w), audio_data, correlation);
+        
+        energy[0] = 0.0;
+        for (size_t i = 0; i < window_size; ++i) {
+            energy[i + 1] = energy[i] + static_cast<double>(audio_data[i]) * audio_data[i];
+        }
+        
+        // Cumulative mean normalized difference, d'(0) = 1
+        const double e0 = energy[w];
+        double running_sum = 0.0;
+        difference[0] = 1.0;
+        for (size_t tau = 1; tau <= max_lag + 1; ++tau) {
+            const double d = std::max(0.0, e0 + (energy[tau + w] - energy[tau]) - 2.0 * correlation[tau]);
+            running_sum += d;
+            difference[tau] = running_sum > 0.0 ? d * tau / running_sum : 1.0;
+        }
+        
+        // Absolute threshold: first dip below the threshold, followed down to its minimum
+        size_t best = 0;
+        for (size_t tau = min_lag; tau <= max_lag; ++tau) {
+            if (difference[tau] < threshold) {
+                while (tau + 1 <= max_lag && difference[tau + 1] < difference[tau]) {
+                    ++tau;
+                }
+                best = tau;
+                break;
+            }
+        }
+        
+        // No dip below the threshold: fall back to the global minimum if it is periodic enough
+        if (best == 0) {
+            best = min_lag;
+            for (size_t tau = min_lag + 1; tau <= max_lag; ++tau) {
+                if (difference[tau] < difference[best]) {
+                    best = tau;
+                }
+            }
+            if (difference[best] > unvoiced_limit) {
+                return std::unexpected(TunerError("No periodic signal found"));
+            }
+        }
+        
+        // Parabolic interpolation around the chosen lag
+        const double a = difference[best - 1];
+        const double b = difference[best];
+        const double c = difference[best + 1];
+        const double denom = a - 2.0 * b + c;
+        const double lag = denom > 0.0 ? best + 0.5 * (a - c) / denom : static_cast<double>(best);
+        
+        return sample_rate / lag;
+    }
+};